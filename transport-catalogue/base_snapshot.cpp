@@ -0,0 +1,119 @@
+#include "base_snapshot.h"
+
+#include "serialization.h"
+
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace transport_catalogue {
+
+    void FillCatalogue(const serialization_data::SerializationData& data,
+                       const std::unordered_map<uint32_t, std::string>& id_names,
+                       TransportCatalogue& db) {
+        std::vector<std::tuple<std::string, int, std::string>> stop_distance_to_stop;
+        std::vector<std::tuple<std::string, std::vector<std::string>, bool>> buses_and_stops;
+
+        for (auto& [name, coord, r_d] : data.stops) {
+            db.AddStop({id_names.at(name),
+                        coord.lat,
+                        coord.lng});
+            for (auto [to_stop, distances] : r_d) {
+                stop_distance_to_stop.push_back({id_names.at(name), distances, id_names.at(to_stop)});
+            }
+        }
+
+        for (auto& [name, stops_id, is_roundtrip] : data.buses) {
+            std::vector<std::string> stops;
+            for (auto& node_str : stops_id) {
+                stops.push_back(id_names.at(node_str));
+            }
+
+            buses_and_stops.push_back({id_names.at(name), std::move(stops), is_roundtrip});
+        }
+
+        for (auto& sds : stop_distance_to_stop) {
+            db.SetDistanceBetweenStops(sds);
+        }
+
+        for (auto& [bus, stops, is_roundtrip] : buses_and_stops) {
+            db.AddBus(bus, stops, is_roundtrip);
+        }
+
+        db.Freeze();
+    }
+
+    BaseSnapshot::BaseSnapshot(uint64_t version, std::filesystem::path base_file,
+                               std::filesystem::file_time_type base_write_time,
+                               serialization_data::SerializationData&& data)
+    : version_(version), base_file_(std::move(base_file)), base_write_time_(base_write_time) {
+        id_names_ = std::unordered_map<uint32_t, std::string>(data.name_repository.begin(), data.name_repository.end());
+
+        FillCatalogue(data, id_names_, db_);
+
+        vs_ = std::move(data.vs);
+        route_settings_ = data.route_settings;
+        router_data_ = std::move(data.router_data);
+    }
+
+    const RouteBuilder& BaseSnapshot::GetRouteBuilder() const {
+        std::call_once(route_builder_flag_, [this] {
+            const auto& rs = route_settings_;
+            route_builder_ = std::make_unique<RouteBuilder>(db_, rs.bus_velocity, rs.bus_wait_time, rs.router_type,
+                                                            rs.graph_model, rs.weight_type, std::move(router_data_),
+                                                            id_names_, rs.route_cache_size);
+            router_data_ = {};
+            id_names_.clear();
+        });
+
+        return *route_builder_;
+    }
+
+    const transit::RaptorRouter& BaseSnapshot::GetRaptor() const {
+        if (route_settings_.router_type == RouterType::kRaptor) {
+            return *GetRouteBuilder().GetRaptor();
+        }
+
+        std::call_once(raptor_flag_, [this] {
+            raptor_ = std::make_unique<transit::RaptorRouter>(db_, route_settings_.bus_velocity,
+                                                              route_settings_.bus_wait_time);
+        });
+
+        return *raptor_;
+    }
+
+    BaseSnapshotPtr BaseVersions::Read(const std::filesystem::path& base_file) {
+        const uint64_t version = next_version_.fetch_add(1);
+        // Время изменения берётся до чтения: если файл заменят во время чтения, версия окажется устаревшей
+        const auto base_write_time = std::filesystem::last_write_time(base_file);
+
+        return std::make_shared<const BaseSnapshot>(version, base_file, base_write_time, Deserialize(base_file));
+    }
+
+    BaseSnapshotPtr BaseVersions::Load(const std::filesystem::path& base_file) {
+        auto snapshot = Read(base_file);
+        Publish(snapshot);
+
+        return snapshot;
+    }
+
+    std::future<BaseSnapshotPtr> BaseVersions::LoadAsync(std::filesystem::path base_file) {
+        return std::async(std::launch::async, [this, base_file = std::move(base_file)] {
+            auto snapshot = Read(base_file);
+            snapshot->GetRouteBuilder();
+            Publish(snapshot);
+
+            return snapshot;
+        });
+    }
+
+    void BaseVersions::Publish(BaseSnapshotPtr snapshot) {
+        BaseSnapshotPtr current = std::atomic_load(&current_);
+        // Загрузки могут завершиться не в порядке начала; более старая версия не вытесняет более новую
+        while (!current || current->GetVersion() < snapshot->GetVersion()) {
+            if (std::atomic_compare_exchange_weak(&current_, &current, snapshot)) {
+                return;
+            }
+        }
+    }
+}
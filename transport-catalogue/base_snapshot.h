@@ -0,0 +1,115 @@
+#pragma once
+
+#include "domain.h"
+#include "raptor.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// base_snapshot — версии базы, с которыми работает process_requests. Версия неизменяема: замороженный каталог,
+// настройки визуализации и маршрутизатор. Читатель берёт shared_ptr на текущую версию и отвечает по ней до конца,
+// писатель собирает следующую версию отдельно и публикует её атомарной заменой указателя.
+// Прежняя версия освобождается, когда её отпустит последний читатель
+
+namespace transport_catalogue {
+
+    // Заполняет каталог по данным базы и замораживает его; id_names — названия по идентификаторам базы
+    void FillCatalogue(const serialization_data::SerializationData& data,
+                       const std::unordered_map<uint32_t, std::string>& id_names,
+                       TransportCatalogue& db);
+
+    class BaseSnapshot {
+    public:
+        // base_write_time — время изменения файла базы, прочитанного в data
+        BaseSnapshot(uint64_t version, std::filesystem::path base_file,
+                     std::filesystem::file_time_type base_write_time,
+                     serialization_data::SerializationData&& data);
+
+        BaseSnapshot(const BaseSnapshot&) = delete;
+        BaseSnapshot& operator=(const BaseSnapshot&) = delete;
+
+        uint64_t GetVersion() const {
+            return version_;
+        }
+
+        const std::filesystem::path& GetBaseFile() const {
+            return base_file_;
+        }
+
+        std::filesystem::file_time_type GetBaseWriteTime() const {
+            return base_write_time_;
+        }
+
+        const TransportCatalogue& GetCatalogue() const {
+            return db_;
+        }
+
+        const renderer::VisualizationSettings& GetVisualizationSettings() const {
+            return vs_;
+        }
+
+        // Маршрутизатор версии строится при первом вызове; одновременные первые вызовы ждут одно построение
+        const RouteBuilder& GetRouteBuilder() const;
+
+        // Индекс raptor для маршрутов Парето. При движке raptor это индекс маршрутизатора; при остальных движках
+        // он строится отдельно при первом вызове, граф и таблица маршрутизатора для него не восстанавливаются
+        const transit::RaptorRouter& GetRaptor() const;
+
+    private:
+        uint64_t version_;
+        std::filesystem::path base_file_;
+        std::filesystem::file_time_type base_write_time_;
+
+        TransportCatalogue db_;
+        renderer::VisualizationSettings vs_;
+
+        // Данные маршрутизатора из базы; переносятся в route_builder_ при его построении
+        serialization_data::RouteSettings route_settings_;
+        mutable serialization_data::RouterData router_data_;
+        mutable std::unordered_map<uint32_t, std::string> id_names_;
+
+        mutable std::once_flag route_builder_flag_;
+        mutable std::unique_ptr<RouteBuilder> route_builder_;
+
+        mutable std::once_flag raptor_flag_;
+        mutable std::unique_ptr<transit::RaptorRouter> raptor_;
+    };
+
+    using BaseSnapshotPtr = std::shared_ptr<const BaseSnapshot>;
+
+    class BaseVersions {
+    public:
+        // Текущая версия или nullptr, пока ничего не опубликовано. Читатель не ждёт, пока писатель загружает
+        // следующую версию. Сама подмена указателя не lock-free: в libstdc++ std::atomic_load для shared_ptr
+        // берёт мьютекс из внутреннего пула, поэтому читатель может коротко ждать копирования указателя
+        BaseSnapshotPtr Acquire() const {
+            return std::atomic_load(&current_);
+        }
+
+        // Читает файл базы, публикует новую версию и возвращает её
+        BaseSnapshotPtr Load(const std::filesystem::path& base_file);
+
+        // То же в отдельном потоке; до готовности новой версии запросы обслуживает прежняя. Маршрутизатор новой
+        // версии строится в том же потоке до публикации, чтобы первый запрос маршрута не ждал восстановления графа
+        std::future<BaseSnapshotPtr> LoadAsync(std::filesystem::path base_file);
+
+        // Делает snapshot текущей версией, если раньше не была опубликована более новая
+        void Publish(BaseSnapshotPtr snapshot);
+
+    private:
+        // Читает файл базы в новую версию, не публикуя её
+        BaseSnapshotPtr Read(const std::filesystem::path& base_file);
+
+        // Доступ только через std::atomic_load и std::atomic_compare_exchange; C++17 не даёт std::atomic<shared_ptr>
+        BaseSnapshotPtr current_;
+        std::atomic<uint64_t> next_version_ = 1;
+    };
+}
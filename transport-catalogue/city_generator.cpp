@@ -0,0 +1,330 @@
+#include "city_generator.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <optional>
+#include <random>
+#include <tuple>
+
+using namespace std::literals;
+
+namespace synthetic {
+
+    namespace {
+
+        // Центр города и расстояние между соседними узлами сетки или кольцами
+        constexpr geo::Coordinates CENTER{43.58, 39.72};
+        constexpr double NODE_SPACING_METERS = 400.;
+        constexpr double PI = 3.1415926535;
+        constexpr double METERS_IN_LATITUDE_DEGREE = PI * geo::kGroundRadius / 180.;
+
+        // Дороги длиннее прямой на 10–40%; у части улиц расстояние в обратную сторону задано отдельно
+        constexpr double MIN_ROAD_DETOUR = 1.1;
+        constexpr double MAX_ROAD_DETOUR = 1.4;
+        constexpr double ASYMMETRIC_ROAD_SHARE = 0.2;
+
+        // Вероятность, что некольцевой автобус на перекрёстке продолжит ехать прямо
+        constexpr double KEEP_DIRECTION_PROBABILITY = 0.7;
+        constexpr size_t MAX_PLACEMENT_ATTEMPTS = 16;
+
+        // Узлы образуют rows × columns ячеек, строка за строкой; последняя строка может быть неполной.
+        // В радиальной раскладке строка — кольцо, столбец — радиальная улица
+        class StreetPlan {
+        public:
+            // Соседи узла: вверх, вниз, влево, вправо
+            using Neighbours = std::array<std::optional<size_t>, 4>;
+
+            StreetPlan(size_t stop_count, CityLayout layout)
+            : stop_count_(stop_count), layout_(layout) {
+                rows_ = std::max<size_t>(1, static_cast<size_t>(std::sqrt(static_cast<double>(stop_count))));
+                columns_ = (stop_count + rows_ - 1) / rows_;
+                // Замыкать по кругу имеет смысл, только если радиальных улиц хотя бы три
+                wraps_columns_ = layout == CityLayout::kRadial && columns_ >= 3;
+            }
+
+            size_t GetRows() const {
+                return rows_;
+            }
+
+            size_t GetColumns() const {
+                return columns_;
+            }
+
+            bool WrapsColumns() const {
+                return wraps_columns_;
+            }
+
+            std::optional<size_t> GetNode(size_t row, size_t column) const {
+                if (row >= rows_) {
+                    return std::nullopt;
+                }
+                if (column >= columns_) {
+                    if (!wraps_columns_) {
+                        return std::nullopt;
+                    }
+                    column %= columns_;
+                }
+
+                const size_t node = row * columns_ + column;
+                return node < stop_count_ ? std::optional<size_t>(node) : std::nullopt;
+            }
+
+            Neighbours GetNeighbours(size_t node) const {
+                const size_t row = node / columns_;
+                const size_t column = node % columns_;
+
+                Neighbours neighbours;
+                if (row > 0) {
+                    neighbours[0] = GetNode(row - 1, column);
+                }
+                neighbours[1] = GetNode(row + 1, column);
+                if (column > 0) {
+                    neighbours[2] = GetNode(row, column - 1);
+                } else if (wraps_columns_) {
+                    neighbours[2] = GetNode(row, columns_ - 1);
+                }
+                neighbours[3] = GetNode(row, column + 1);
+
+                return neighbours;
+            }
+
+            geo::Coordinates GetCoordinates(size_t node, std::mt19937& generator) const {
+                const double row = static_cast<double>(node / columns_);
+                const double column = static_cast<double>(node % columns_);
+
+                double north_meters = 0.;
+                double east_meters = 0.;
+                if (layout_ == CityLayout::kGrid) {
+                    std::uniform_real_distribution<double> jitter(-0.15 * NODE_SPACING_METERS, 0.15 * NODE_SPACING_METERS);
+                    north_meters = (row - rows_ / 2.) * NODE_SPACING_METERS + jitter(generator);
+                    east_meters = (column - columns_ / 2.) * NODE_SPACING_METERS + jitter(generator);
+                } else {
+                    const double radius = (row + 1.) * NODE_SPACING_METERS;
+                    const double angle = 2. * PI * column / columns_;
+                    north_meters = radius * std::cos(angle);
+                    east_meters = radius * std::sin(angle);
+                }
+
+                const double latitude = CENTER.lat + north_meters / METERS_IN_LATITUDE_DEGREE;
+                const double longitude = CENTER.lng
+                        + east_meters / (METERS_IN_LATITUDE_DEGREE * std::cos(CENTER.lat * PI / 180.));
+                return {latitude, longitude};
+            }
+
+        private:
+            size_t stop_count_;
+            CityLayout layout_;
+            size_t rows_;
+            size_t columns_;
+            bool wraps_columns_;
+        };
+
+        void AddRoadDistances(const StreetPlan& plan, std::mt19937& generator, std::vector<CityStop>& stops) {
+            std::uniform_real_distribution<double> detour(MIN_ROAD_DETOUR, MAX_ROAD_DETOUR);
+            std::uniform_real_distribution<double> share(0., 1.);
+
+            for (size_t from = 0; from < stops.size(); ++from) {
+                for (const auto& neighbour : plan.GetNeighbours(from)) {
+                    if (!neighbour || *neighbour <= from) {
+                        continue;
+                    }
+
+                    const double straight = geo::ComputeDistance(stops[from].coordinates,
+                                                                 stops[*neighbour].coordinates);
+                    stops[from].road_distances.emplace_back(*neighbour,
+                                                            static_cast<int>(std::ceil(straight * detour(generator))));
+                    // Без обратного расстояния каталог берёт расстояние в прямую сторону
+                    if (share(generator) < ASYMMETRIC_ROAD_SHARE) {
+                        stops[*neighbour].road_distances.emplace_back(
+                                from, static_cast<int>(std::ceil(straight * detour(generator))));
+                    }
+                }
+            }
+        }
+
+        // Случайный путь по улицам без повторных остановок; на перекрёстке автобус чаще едет прямо
+        std::vector<size_t> MakeLinearRoute(const StreetPlan& plan, size_t stop_count, size_t length,
+                                            std::mt19937& generator) {
+            std::uniform_int_distribution<size_t> node_distribution(0, stop_count - 1);
+            std::uniform_real_distribution<double> share(0., 1.);
+
+            std::vector<size_t> route{node_distribution(generator)};
+            std::optional<size_t> direction;
+
+            while (route.size() < length) {
+                const auto neighbours = plan.GetNeighbours(route.back());
+
+                std::vector<size_t> candidates;
+                for (size_t i = 0; i < neighbours.size(); ++i) {
+                    if (neighbours[i] && std::find(route.begin(), route.end(), *neighbours[i]) == route.end()) {
+                        candidates.push_back(i);
+                    }
+                }
+                if (candidates.empty()) {
+                    break;
+                }
+
+                const bool can_keep_direction = direction
+                        && std::find(candidates.begin(), candidates.end(), *direction) != candidates.end();
+                if (!can_keep_direction || share(generator) >= KEEP_DIRECTION_PROBABILITY) {
+                    direction = candidates[std::uniform_int_distribution<size_t>(0, candidates.size() - 1)(generator)];
+                }
+                route.push_back(*neighbours[*direction]);
+            }
+
+            return route;
+        }
+
+        // Кольцо по периметру прямоугольника улиц с периметром около length; последняя остановка равна первой.
+        // Пусто, если такой прямоугольник не помещается в город
+        std::vector<size_t> MakeRoundtripRoute(const StreetPlan& plan, size_t length, std::mt19937& generator) {
+            const size_t rows = plan.GetRows();
+            const size_t columns = plan.GetColumns();
+            if (rows < 2 || columns < 2) {
+                return {};
+            }
+
+            const size_t half = std::max<size_t>(2, length / 2);
+            const size_t height = std::min(rows - 1,
+                                           std::uniform_int_distribution<size_t>(1, half - 1)(generator));
+            const size_t width = std::min(columns - 1, half - height);
+
+            const size_t top = std::uniform_int_distribution<size_t>(0, rows - 1 - height)(generator);
+            const size_t left = std::uniform_int_distribution<size_t>(
+                    0, plan.WrapsColumns() ? columns - 1 : columns - 1 - width)(generator);
+
+            std::vector<std::pair<size_t, size_t>> cells;
+            for (size_t column = left; column < left + width; ++column) {
+                cells.emplace_back(top, column);
+            }
+            for (size_t row = top; row < top + height; ++row) {
+                cells.emplace_back(row, left + width);
+            }
+            for (size_t column = left + width; column > left; --column) {
+                cells.emplace_back(top + height, column);
+            }
+            for (size_t row = top + height; row > top; --row) {
+                cells.emplace_back(row, left);
+            }
+            cells.push_back(cells.front());
+
+            std::vector<size_t> route;
+            for (const auto& [row, column] : cells) {
+                const auto node = plan.GetNode(row, column);
+                if (!node) {
+                    return {};
+                }
+                route.push_back(*node);
+            }
+
+            return route;
+        }
+    }
+
+    City GenerateCity(const CityOptions& options) {
+        City city;
+        if (options.stop_count == 0) {
+            return city;
+        }
+
+        std::mt19937 generator(options.seed);
+        const StreetPlan plan(options.stop_count, options.layout);
+
+        city.stops.reserve(options.stop_count);
+        for (size_t i = 0; i < options.stop_count; ++i) {
+            city.stops.push_back({"S"s + std::to_string(i), plan.GetCoordinates(i, generator), {}});
+        }
+        AddRoadDistances(plan, generator, city.stops);
+
+        if (options.stop_count < 2) {
+            return city;
+        }
+
+        const size_t min_bus_stops = std::clamp<size_t>(options.min_bus_stops, 2, options.stop_count);
+        const size_t max_bus_stops = std::clamp<size_t>(options.max_bus_stops, min_bus_stops, options.stop_count);
+        std::uniform_int_distribution<size_t> length_distribution(min_bus_stops, max_bus_stops);
+        std::uniform_real_distribution<double> share(0., 1.);
+
+        city.buses.reserve(options.bus_count);
+        for (size_t i = 0; i < options.bus_count; ++i) {
+            const size_t length = length_distribution(generator);
+
+            std::vector<size_t> route;
+            bool is_roundtrip = share(generator) < options.roundtrip_share;
+            if (is_roundtrip) {
+                for (size_t attempt = 0; attempt < MAX_PLACEMENT_ATTEMPTS && route.empty(); ++attempt) {
+                    route = MakeRoundtripRoute(plan, length, generator);
+                }
+                is_roundtrip = !route.empty();
+            }
+            for (size_t attempt = 0; attempt < MAX_PLACEMENT_ATTEMPTS && route.size() < 2; ++attempt) {
+                route = MakeLinearRoute(plan, options.stop_count, length, generator);
+            }
+
+            if (route.size() >= 2) {
+                city.buses.push_back({"B"s + std::to_string(i), std::move(route), is_roundtrip});
+            }
+        }
+
+        return city;
+    }
+
+    json::Node MakeBaseRequests(const City& city) {
+        json::Array requests;
+        requests.reserve(city.stops.size() + city.buses.size());
+
+        for (const auto& stop : city.stops) {
+            json::Dict road_distances;
+            for (const auto& [to, distance] : stop.road_distances) {
+                road_distances[city.stops[to].name] = distance;
+            }
+
+            requests.push_back(json::Dict{{"type"s, "Stop"s},
+                                          {"name"s, stop.name},
+                                          {"latitude"s, stop.coordinates.lat},
+                                          {"longitude"s, stop.coordinates.lng},
+                                          {"road_distances"s, std::move(road_distances)}});
+        }
+
+        for (const auto& bus : city.buses) {
+            json::Array stops;
+            for (const size_t stop : bus.stops) {
+                stops.push_back(city.stops[stop].name);
+            }
+
+            requests.push_back(json::Dict{{"type"s, "Bus"s},
+                                          {"name"s, bus.name},
+                                          {"stops"s, std::move(stops)},
+                                          {"is_roundtrip"s, bus.is_roundtrip}});
+        }
+
+        return requests;
+    }
+
+    void FillCatalogue(const City& city, transport_catalogue::TransportCatalogue& db) {
+        for (const auto& stop : city.stops) {
+            db.AddStop({stop.name, stop.coordinates.lat, stop.coordinates.lng});
+        }
+
+        for (const auto& stop : city.stops) {
+            for (const auto& [to, distance] : stop.road_distances) {
+                std::tuple<std::string, int, std::string> stop_distance_to_stop{stop.name, distance,
+                                                                                city.stops[to].name};
+                db.SetDistanceBetweenStops(stop_distance_to_stop);
+            }
+        }
+
+        for (const auto& bus : city.buses) {
+            std::vector<std::string> stops;
+            for (const size_t stop : bus.stops) {
+                stops.push_back(city.stops[stop].name);
+            }
+
+            std::string name = bus.name;
+            db.AddBus(name, stops, bus.is_roundtrip);
+        }
+
+        db.Freeze();
+    }
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "geo.h"
+#include "json.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// city_generator — синтетический город для замеров маршрутизации: остановки в узлах сетки или на кольцах
+// с радиальными улицами, дорожные расстояния между соседними узлами и автобусы, идущие по этим улицам
+
+namespace synthetic {
+
+    enum class CityLayout {
+        // Прямоугольная сетка улиц
+        kGrid,
+        // Кольца вокруг центра, соединённые радиальными улицами; номер столбца замыкается по кругу
+        kRadial,
+    };
+
+    struct CityOptions {
+        size_t stop_count = 1000;
+        size_t bus_count = 100;
+        CityLayout layout = CityLayout::kGrid;
+        // Число остановок в описании автобуса; у кольцевого последняя совпадает с первой и не считается
+        size_t min_bus_stops = 5;
+        size_t max_bus_stops = 20;
+        // Доля кольцевых автобусов, остальные ходят туда и обратно
+        double roundtrip_share = 0.5;
+        uint32_t seed = 42;
+    };
+
+    struct CityStop {
+        std::string name;
+        geo::Coordinates coordinates;
+        // Дорожные расстояния от этой остановки: номер соседней остановки и метры
+        std::vector<std::pair<size_t, int>> road_distances;
+    };
+
+    struct CityBus {
+        std::string name;
+        // Номера остановок в том виде, в каком их задаёт base_requests
+        std::vector<size_t> stops;
+        bool is_roundtrip;
+    };
+
+    struct City {
+        std::vector<CityStop> stops;
+        std::vector<CityBus> buses;
+    };
+
+    City GenerateCity(const CityOptions& options);
+
+    // Массив base_requests в формате make_base
+    json::Node MakeBaseRequests(const City& city);
+
+    // Заполняет каталог так же, как make_base по base_requests этого города, и замораживает его
+    void FillCatalogue(const City& city, transport_catalogue::TransportCatalogue& db);
+}
@@ -0,0 +1,95 @@
+#include "city_generator.h"
+#include "json.h"
+
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// city_generator — печатает входные данные make_base для синтетического города.
+// Запуск: city_generator [stop_count] [bus_count] [grid|radial] [min_bus_stops] [max_bus_stops]
+//                        [roundtrip_share] [seed] > base.json
+
+using namespace std::literals;
+
+namespace {
+
+    void PrintUsage(std::ostream& stream = std::cerr) {
+        stream << "Usage: city_generator [stop_count] [bus_count] [grid|radial] [min_bus_stops] [max_bus_stops] "
+                  "[roundtrip_share] [seed]\n"sv;
+    }
+
+    std::optional<synthetic::CityOptions> ParseOptions(int argc, char* argv[]) {
+        synthetic::CityOptions options;
+
+        try {
+            if (argc > 1) {
+                options.stop_count = std::stoul(argv[1]);
+            }
+            if (argc > 2) {
+                options.bus_count = std::stoul(argv[2]);
+            }
+            if (argc > 3) {
+                if (argv[3] == "grid"sv) {
+                    options.layout = synthetic::CityLayout::kGrid;
+                } else if (argv[3] == "radial"sv) {
+                    options.layout = synthetic::CityLayout::kRadial;
+                } else {
+                    return std::nullopt;
+                }
+            }
+            if (argc > 4) {
+                options.min_bus_stops = std::stoul(argv[4]);
+            }
+            if (argc > 5) {
+                options.max_bus_stops = std::stoul(argv[5]);
+            }
+            if (argc > 6) {
+                options.roundtrip_share = std::stod(argv[6]);
+            }
+            if (argc > 7) {
+                options.seed = static_cast<uint32_t>(std::stoul(argv[7]));
+            }
+        } catch (const std::exception&) {
+            return std::nullopt;
+        }
+
+        if (argc > 8) {
+            return std::nullopt;
+        }
+        return options;
+    }
+
+    json::Dict MakeRenderSettings() {
+        return {{"width"s, 1200.},
+                {"height"s, 1200.},
+                {"padding"s, 50.},
+                {"line_width"s, 14.},
+                {"stop_radius"s, 5.},
+                {"bus_label_font_size"s, 20},
+                {"bus_label_offset"s, json::Array{7., 15.}},
+                {"stop_label_font_size"s, 20},
+                {"stop_label_offset"s, json::Array{7., -3.}},
+                {"underlayer_color"s, json::Array{255, 255, 255, 0.85}},
+                {"underlayer_width"s, 3.},
+                {"color_palette"s, json::Array{"green"s, json::Array{255, 160, 0}, "red"s}}};
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const auto options = ParseOptions(argc, argv);
+    if (!options) {
+        PrintUsage();
+        return 1;
+    }
+
+    const synthetic::City city = synthetic::GenerateCity(*options);
+
+    json::Dict document{{"base_requests"s, synthetic::MakeBaseRequests(city)},
+                        {"render_settings"s, MakeRenderSettings()},
+                        {"routing_settings"s, json::Dict{{"bus_velocity"s, 40.}, {"bus_wait_time"s, 6.}}},
+                        {"serialization_settings"s, json::Dict{{"file"s, "city.db"s}}}};
+
+    json::Print(json::Document(json::Node(std::move(document))), std::cout);
+    std::cout << '\n';
+}
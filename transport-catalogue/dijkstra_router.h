@@ -0,0 +1,184 @@
+#pragma once
+
+#include "graph.h"
+#include "radix_heap.h"
+#include "router.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Маршрутизатор без предварительного расчёта: каждый запрос решается алгоритмом Дейкстры
+// на двоичной куче. Построение — O(E) на проверку весов, память — линейна по размеру графа.
+// Если задана эвристика, поиск становится целенаправленным (A*): вершины извлекаются в порядке
+// вес + heuristic(vertex, to). Эвристика должна быть согласованной — не больше веса любого ребра
+// плюс эвристика его конца, — иначе найденный маршрут может оказаться не кратчайшим.
+// Для целых беззнаковых весов вместо двоичной кучи используется монотонная RadixHeap
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class DijkstraRouter : public RouterBase<Weight> {
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using RoutesTree = typename RouterBase<Weight>::RoutesTree;
+    // Нижняя оценка веса пути от вершины до цели
+    using Heuristic = std::function<Weight(VertexId vertex, VertexId to)>;
+
+    explicit DijkstraRouter(const Graph& graph, Heuristic heuristic = {});
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // Полный поиск из from без остановки на цели; эвристика A* при этом не применяется
+    RoutesTree BuildRoutesTree(VertexId from) const override;
+    std::optional<RouteInfo> BuildRoute(const RoutesTree& tree, VertexId to) const override;
+
+private:
+    // Поиск из from; если задана цель to, он останавливается на ней и направляется эвристикой
+    RoutesTree Search(VertexId from, std::optional<VertexId> to) const;
+
+    void CheckVertex(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    const Graph& graph_;
+    Heuristic heuristic_;
+};
+
+template <typename Weight, typename Graph>
+DijkstraRouter<Weight, Graph>::DijkstraRouter(const Graph& graph, Heuristic heuristic)
+    : graph_(graph)
+    , heuristic_(std::move(heuristic))
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename DijkstraRouter<Weight, Graph>::RouteInfo> DijkstraRouter<Weight, Graph>::BuildRoute(
+        VertexId from, VertexId to) const {
+    CheckVertex(from);
+    CheckVertex(to);
+
+    return BuildRoute(Search(from, to), to);
+}
+
+template <typename Weight, typename Graph>
+typename DijkstraRouter<Weight, Graph>::RoutesTree DijkstraRouter<Weight, Graph>::BuildRoutesTree(VertexId from) const {
+    CheckVertex(from);
+
+    return Search(from, std::nullopt);
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename DijkstraRouter<Weight, Graph>::RouteInfo> DijkstraRouter<Weight, Graph>::BuildRoute(
+        const RoutesTree& tree, VertexId to) const {
+    CheckVertex(to);
+    if (!tree.weights[to]) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (std::optional<EdgeId> edge_id = tree.prev_edges[to];
+         edge_id;
+         edge_id = tree.prev_edges[graph_.GetEdge(*edge_id).from])
+    {
+        edges.push_back(*edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{*tree.weights[to], std::move(edges)};
+}
+
+template <typename Weight, typename Graph>
+typename DijkstraRouter<Weight, Graph>::RoutesTree DijkstraRouter<Weight, Graph>::Search(
+        VertexId from, std::optional<VertexId> to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    const bool use_heuristic = heuristic_ && to;
+
+    RoutesTree tree{from, std::vector<std::optional<Weight>>(vertex_count), std::vector<std::optional<EdgeId>>(vertex_count)};
+    auto& weights = tree.weights;
+    auto& prev_edges = tree.prev_edges;
+    // Приоритет — вес пути, с эвристикой A* — вес плюс оценка остатка; значение — вес пути и вершина
+    SearchQueue<Weight, std::pair<Weight, VertexId>> queue;
+
+    weights[from] = ZERO_WEIGHT;
+    queue.Push(use_heuristic ? heuristic_(from, *to) : ZERO_WEIGHT, {ZERO_WEIGHT, from});
+
+    while (!queue.IsEmpty()) {
+        const auto [weight, vertex] = queue.Pop().second;
+
+        // В очереди могут остаться устаревшие записи — их пропускаем
+        if (*weights[vertex] < weight) {
+            continue;
+        }
+        if (vertex == to) {
+            break;
+        }
+
+        for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+            const auto& edge = graph_.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            auto& weight_to = weights[edge.to];
+            if (!weight_to || candidate_weight < *weight_to) {
+                weight_to = candidate_weight;
+                prev_edges[edge.to] = edge_id;
+                queue.Push(use_heuristic ? candidate_weight + heuristic_(edge.to, *to) : candidate_weight,
+                           {candidate_weight, edge.to});
+            }
+        }
+    }
+
+    return tree;
+}
+
+// Вершины, достижимые из from путём веса не больше max_weight, с весами путей в порядке неубывания веса.
+// Пути тяжелее max_weight не продолжаются, а веса хранятся только для встреченных вершин,
+// поэтому стоимость зависит от числа найденных вершин и их рёбер, а не от размера графа
+template <typename Weight, typename Graph>
+std::vector<std::pair<VertexId, Weight>> FindVerticesWithinWeight(const Graph& graph, VertexId from, Weight max_weight) {
+    if (from >= graph.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    std::vector<std::pair<VertexId, Weight>> vertices;
+    std::unordered_map<VertexId, Weight> weights;
+    SearchQueue<Weight, VertexId> queue;
+
+    weights[from] = Weight{};
+    queue.Push(Weight{}, from);
+
+    while (!queue.IsEmpty()) {
+        const auto [weight, vertex] = queue.Pop();
+        if (weights.at(vertex) < weight) {
+            continue;
+        }
+        vertices.emplace_back(vertex, weight);
+
+        for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
+            const auto& edge = graph.GetEdge(edge_id);
+            const Weight candidate_weight = weight + edge.weight;
+            if (candidate_weight > max_weight) {
+                continue;
+            }
+            const auto [it, inserted] = weights.emplace(edge.to, candidate_weight);
+            if (inserted || candidate_weight < it->second) {
+                it->second = candidate_weight;
+                queue.Push(candidate_weight, edge.to);
+            }
+        }
+    }
+
+    return vertices;
+}
+
+}  // namespace graph
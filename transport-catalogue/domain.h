@@ -3,27 +3,107 @@
 #include "geo.h"
 #include "svg.h"
 
+#include <cstdint>
 #include <string_view>
 #include <string>
 #include <vector>
 #include <unordered_set>
 #include <unordered_map>
+#include <optional>
 
 // domain — классы основных сущностей, описывают автобусы и остановки;
 
 namespace transport_catalogue {
 
+    // Остановки и автобусы нумеруются подряд с нуля в порядке добавления в каталог
+    using StopId = uint32_t;
+    using BusId = uint32_t;
+
+    // Названия указывают в пул строк каталога и живут, пока жив каталог
     struct Stop {
-        std::string stop_name;
+        StopId id;
+        std::string_view stop_name;
         geo::Coordinates coordinates;
     };
 
+    // Полный путь автобуса поверх хранимых остановок. У некольцевого автобуса хранится только путь туда,
+    // а обратная половина получается чтением тех же остановок в обратном порядке: A B C — это A B C B A
+    class RouteView {
+    public:
+        class Iterator {
+        public:
+            Iterator(const RouteView& route, size_t index)
+            : route_(&route), index_(index) {
+            }
+
+            Stop* operator*() const {
+                return (*route_)[index_];
+            }
+
+            Iterator& operator++() {
+                ++index_;
+                return *this;
+            }
+
+            bool operator==(const Iterator& other) const {
+                return index_ == other.index_;
+            }
+
+            bool operator!=(const Iterator& other) const {
+                return !(*this == other);
+            }
+
+        private:
+            const RouteView* route_;
+            size_t index_;
+        };
+
+        RouteView(const std::vector<Stop*>& stops, bool is_roundtrip)
+        : stops_(&stops), is_roundtrip_(is_roundtrip) {
+        }
+
+        size_t size() const {
+            return is_roundtrip_ || stops_->empty() ? stops_->size() : stops_->size() * 2 - 1;
+        }
+
+        bool empty() const {
+            return stops_->empty();
+        }
+
+        Stop* operator[](size_t index) const {
+            return index < stops_->size() ? (*stops_)[index] : (*stops_)[size() - 1 - index];
+        }
+
+        Stop* front() const {
+            return stops_->front();
+        }
+
+        Iterator begin() const {
+            return {*this, 0};
+        }
+
+        Iterator end() const {
+            return {*this, size()};
+        }
+
+    private:
+        const std::vector<Stop*>* stops_;
+        bool is_roundtrip_;
+    };
+
     struct Bus {
-        std::string bus_name;
+        BusId id;
+        std::string_view bus_name;
+        // Остановки в том виде, в каком их задаёт base_requests: у некольцевого автобуса — только путь туда
         std::vector<Stop*> stops;
-        std::unordered_set<std::string_view> unique_stops;
+        size_t unique_stop_count;
         bool is_roundtrip;
 
+        // Полный путь туда и обратно
+        RouteView GetRoute() const {
+            return {stops, is_roundtrip};
+        }
+
         int route_length = 0;
         double geographic_distance = 0.;
     };
@@ -54,6 +134,29 @@ namespace renderer {
     };
 }
 
+// Движок, которым RouteBuilder отвечает на запросы Route
+enum class RouterType {
+    kAllPairs,
+    kDijkstra,
+    kAStar,
+    // Поиск по раундам по последовательностям остановок автобусов, без графа маршрутов
+    kRaptor,
+};
+
+// Модель графа маршрутов: pairwise — ребро на каждую пару остановок рейса,
+// linear — вершины «еду автобусом X через остановку S», соединённые перегонами; рёбер O(длины рейсов)
+enum class GraphModel {
+    kPairwise,
+    kLinear,
+};
+
+// Тип весов графа маршрутов: minutes — минуты в double,
+// fixed_point — целые сотые доли секунды; в минуты они переводятся только в ответе на запрос
+enum class WeightType {
+    kMinutes,
+    kFixedPoint,
+};
+
 namespace serialization_data {
 
     struct RoadDistances {
@@ -76,6 +179,35 @@ namespace serialization_data {
    struct RouteSettings {
        double bus_velocity;
        double bus_wait_time;
+       RouterType router_type = RouterType::kAllPairs;
+       GraphModel graph_model = GraphModel::kPairwise;
+       WeightType weight_type = WeightType::kMinutes;
+       // Число ответов на запросы Route, которые хранит кеш процесса process_requests
+       uint32_t route_cache_size = 4096;
+    };
+
+    // Ребро графа маршрутов; name — индекс в RouterData::names
+    struct GraphEdge {
+        uint32_t from;
+        uint32_t to;
+        double weight;
+        uint32_t name;
+        uint32_t span_count;
+    };
+
+    // Граф в формате CSR и предрассчитанные таблицы маршрутизатора, построенные на этапе make_base
+    struct RouterData {
+        // Идентификаторы названий, на которые ссылаются рёбра: сначала остановки, затем автобусы
+        std::vector<uint32_t> names;
+        // Вершина входа на остановку names[i]
+        std::vector<uint32_t> stop_vertices;
+        std::vector<GraphEdge> edges;
+        std::vector<uint32_t> offsets;
+        // Плоские матрицы V×V таблицы маршрутизатора all_pairs; пусты, если выбранный движок не хранит таблиц
+        std::vector<double> route_weights;
+        std::vector<uint32_t> route_prev_edges;
+        // Расстояние от начала рейса для вершин поездки модели linear; пусто в модели pairwise
+        std::vector<double> ride_distances;
     };
 
     struct SerializationData {
@@ -84,6 +216,7 @@ namespace serialization_data {
         std::vector<Bus> buses;
         renderer::VisualizationSettings vs;
         RouteSettings route_settings;
+        RouterData router_data;
     };
 
 }
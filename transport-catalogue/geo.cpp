@@ -2,6 +2,7 @@
 
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
@@ -12,9 +13,30 @@ namespace geo {
             return 0;
         }
         static const double dr = M_PI / 180.;
-        return acos(sin(from.lat * dr) * sin(to.lat * dr)
-                    + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-               * kGroundRadius;
+        // У близких точек косинус угла из-за округления может чуть превысить 1, и acos вернул бы NaN
+        const double angle_cos = sin(from.lat * dr) * sin(to.lat * dr)
+                                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr);
+        return acos(min(1., max(-1., angle_cos))) * kGroundRadius;
+    }
+
+    UnitVector ToUnitVector(Coordinates point) {
+        static const double dr = M_PI / 180.;
+        const double lat_cos = std::cos(point.lat * dr);
+        return {lat_cos * std::cos(point.lng * dr), lat_cos * std::sin(point.lng * dr), std::sin(point.lat * dr)};
+    }
+
+    void ComputeDistances(const UnitVector* from, const UnitVector* to, size_t count, double* distances) {
+        // Угол через хорду, а не через acos скалярного произведения: у близких точек произведение почти 1
+        // и acos теряет точность, а хорда совпадающих точек ровно 0
+        for (size_t i = 0; i < count; ++i) {
+            const double dx = from[i].x - to[i].x;
+            const double dy = from[i].y - to[i].y;
+            const double dz = from[i].z - to[i].z;
+            distances[i] = std::sqrt(dx * dx + dy * dy + dz * dz);
+        }
+        for (size_t i = 0; i < count; ++i) {
+            distances[i] = 2. * std::asin(std::min(1., distances[i] / 2.)) * kGroundRadius;
+        }
     }
 
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstddef>
+
 namespace geo {
 
     static const int kGroundRadius = 6371000;
@@ -16,4 +18,18 @@ namespace geo {
     };
 
     double ComputeDistance(Coordinates from, Coordinates to);
+
+    // Точка на сфере единичного радиуса: x и y лежат в плоскости экватора, z направлена к северному полюсу
+    struct UnitVector {
+        double x;
+        double y;
+        double z;
+    };
+
+    UnitVector ToUnitVector(Coordinates point);
+
+    // distances[i] — расстояние между точками from[i] и to[i] в метрах, то же, что у ComputeDistance.
+    // Тригонометрия точек уже посчитана в векторах, поэтому на пару приходятся длина хорды и один asin.
+    // Хорды считаются отдельным циклом без вызовов функций, который компилятор векторизует
+    void ComputeDistances(const UnitVector* from, const UnitVector* to, size_t count, double* distances);
 }
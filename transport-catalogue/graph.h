@@ -2,9 +2,11 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 #include <string_view>
+#include <utility>
 
 namespace graph {
 
@@ -74,4 +76,94 @@ namespace graph {
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
+
+    // Компактное ребро: 32-битные идентификаторы вершин и индекс названия вместо string_view
+    template <typename Weight>
+    struct CompactEdge {
+        uint32_t from;
+        uint32_t to;
+        Weight weight;
+        uint32_t name_id;
+        uint32_t span_count;
+    };
+
+    // Неизменяемый граф в формате CSR: рёбра лежат одним массивом, отсортированным по начальной вершине,
+    // а рёбра вершины v занимают отрезок [offsets[v], offsets[v + 1]). Идентификатор ребра — его позиция в массиве
+    template <typename Weight>
+    class FrozenGraph {
+    private:
+        using IncidentEdgesRange = ranges::Range<ranges::CountingIterator<EdgeId>>;
+
+    public:
+        FrozenGraph() = default;
+        // Порядок рёбер одной вершины сохраняется таким, каким он был в edges
+        FrozenGraph(size_t vertex_count, std::vector<CompactEdge<Weight>> edges);
+        FrozenGraph(std::vector<uint32_t> offsets, std::vector<CompactEdge<Weight>> edges);
+
+        size_t GetVertexCount() const;
+        size_t GetEdgeCount() const;
+        const CompactEdge<Weight>& GetEdge(EdgeId edge_id) const;
+        IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
+
+        const std::vector<uint32_t>& GetOffsets() const;
+        const std::vector<CompactEdge<Weight>>& GetEdges() const;
+
+    private:
+        std::vector<uint32_t> offsets_;
+        std::vector<CompactEdge<Weight>> edges_;
+    };
+
+    template <typename Weight>
+    FrozenGraph<Weight>::FrozenGraph(size_t vertex_count, std::vector<CompactEdge<Weight>> edges)
+            : offsets_(vertex_count + 1, 0)
+            , edges_(edges.size()) {
+        for (const auto& edge : edges) {
+            ++offsets_.at(edge.from + 1);
+        }
+        for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+            offsets_[vertex + 1] += offsets_[vertex];
+        }
+
+        std::vector<uint32_t> positions(offsets_.begin(), offsets_.end() - 1);
+        for (auto& edge : edges) {
+            edges_[positions[edge.from]++] = std::move(edge);
+        }
+    }
+
+    template <typename Weight>
+    FrozenGraph<Weight>::FrozenGraph(std::vector<uint32_t> offsets, std::vector<CompactEdge<Weight>> edges)
+            : offsets_(std::move(offsets))
+            , edges_(std::move(edges)) {
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetVertexCount() const {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    template <typename Weight>
+    size_t FrozenGraph<Weight>::GetEdgeCount() const {
+        return edges_.size();
+    }
+
+    template <typename Weight>
+    const CompactEdge<Weight>& FrozenGraph<Weight>::GetEdge(EdgeId edge_id) const {
+        return edges_[edge_id];
+    }
+
+    template <typename Weight>
+    typename FrozenGraph<Weight>::IncidentEdgesRange FrozenGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+        return {ranges::CountingIterator<EdgeId>(offsets_[vertex]),
+                ranges::CountingIterator<EdgeId>(offsets_[vertex + 1])};
+    }
+
+    template <typename Weight>
+    const std::vector<uint32_t>& FrozenGraph<Weight>::GetOffsets() const {
+        return offsets_;
+    }
+
+    template <typename Weight>
+    const std::vector<CompactEdge<Weight>>& FrozenGraph<Weight>::GetEdges() const {
+        return edges_;
+    }
 }  // namespace graph
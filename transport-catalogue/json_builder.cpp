@@ -113,7 +113,8 @@ namespace json {
                 nodes_stack_.push_back(&root_);
                 return ArrayItemContext(*this);
             }
-            if (nodes_stack_.size() > 1 && (nodes_stack_[nodes_stack_.size() - 2]->IsDict())) {
+            if (nodes_stack_.size() > 1 && (nodes_stack_[nodes_stack_.size() - 2]->IsDict())
+                && !(nodes_stack_.back()->IsArray() || nodes_stack_.back()->IsDict())) {
                 Node::Value& ref_root = const_cast<Node::Value&>(nodes_stack_.back()->GetValue());
                 ref_root = Array{};
                 return ArrayItemContext(*this);
@@ -5,15 +5,47 @@
 
 #include "serialization.h"
 
+#include <chrono>
+#include <limits>
+#include <map>
 #include <string>
 #include <vector>
 #include <utility>
 #include <tuple>
 #include <algorithm>
+#include <stdexcept>
 
 using namespace transport_catalogue;
 using namespace std;
 
+namespace {
+    // Элементы маршрута в формате ответа на запрос Route
+    void PrintRouteItems(json::Builder& builder, const Route& route) {
+        builder.StartArray();
+
+        for (const auto& item : route.items) {
+            switch (item.item_type) {
+                case Item::Type::kWait :
+                    builder.StartDict()
+                            .Key("type"s).Value("Wait"s)
+                            .Key("time"s).Value(item.time)
+                            .Key("stop_name"s).Value(std::string(item.name))
+                            .EndDict();
+                    break;
+                case Item::Type::kBus:
+                    builder.StartDict()
+                            .Key("type"s).Value("Bus"s)
+                            .Key("span_count"s).Value(item.span_count)
+                            .Key("time"s).Value(item.time)
+                            .Key("bus"s).Value(std::string(item.name))
+                            .EndDict();
+            }
+        }
+
+        builder.EndArray();
+    }
+}
+
 void MapStatRequest::Print(json::Builder& builder) const {
     RequestHandler rh(db_, renderer_);
     std::stringstream strm;
@@ -24,27 +56,20 @@ void MapStatRequest::Print(json::Builder& builder) const {
           .Key("request_id"s).Value(id_).EndDict();
 }
 
-json::Array StopStatRequest::GetBusNames(const unordered_set<Bus*>* stop_buses) const {
-    std::vector<std::string> tmp(stop_buses->size());
-    std::transform(stop_buses->begin(), stop_buses->end(), tmp.begin(), [](Bus* bus){
-        return bus->bus_name;
-    });
-    std::sort(tmp.begin(), tmp.end());
-
-    json::Array buses;
-
-    for (auto& bus : tmp) {
-        buses.emplace_back(bus);
+void StopStatRequest::Evaluate() {
+    if (const auto stop_bus_names = db_.GetStopBusNames(stop_name_)) {
+        bus_names_.emplace();
+        bus_names_->reserve(stop_bus_names->size());
+        for (const auto bus_name : *stop_bus_names) {
+            bus_names_->emplace_back(std::string(bus_name));
+        }
     }
-
-    return buses;
 }
 
 void StopStatRequest::Print(json::Builder& builder) const {
-    auto stop_buses = db_.GetStopInfo(stop_name_);
-    if (stop_buses) {
+    if (bus_names_) {
         builder.StartDict()
-                .Key("buses"s).Value(GetBusNames(stop_buses))
+                .Key("buses"s).Value(*bus_names_)
                 .Key("request_id"s).Value(id_)
                 .EndDict();
     } else {
@@ -55,15 +80,18 @@ void StopStatRequest::Print(json::Builder& builder) const {
     }
 }
 
+void BusStatRequest::Evaluate() {
+    bus_info_ = db_.GetBusInfo(route_name_);
+}
+
 void BusStatRequest::Print(json::Builder& builder) const {
-    auto bus_info = db_.GetBusInfo(route_name_);
-    if (bus_info) {
+    if (bus_info_) {
         builder.StartDict()
                 .Key("request_id"s).Value(id_)
-                .Key("curvature"s).Value(bus_info->curvature)
-                .Key("route_length"s).Value(bus_info->route_length)
-                .Key("stop_count"s).Value(int(bus_info->stop_count))
-                .Key("unique_stop_count"s).Value(int(bus_info->unique_stop_count))
+                .Key("curvature"s).Value(bus_info_->curvature)
+                .Key("route_length"s).Value(bus_info_->route_length)
+                .Key("stop_count"s).Value(int(bus_info_->stop_count))
+                .Key("unique_stop_count"s).Value(int(bus_info_->unique_stop_count))
                 .EndDict();
     } else {
         builder.StartDict()
@@ -73,8 +101,15 @@ void BusStatRequest::Print(json::Builder& builder) const {
     }
 }
 
+void RoutingStatRequest::Evaluate() {
+    if (!source_) {
+        route_ = route_builder_.GetRout(from_, to_);
+    }
+}
+
 void RoutingStatRequest::Print(json::Builder& builder) const {
-    if (!route_) {
+    const RouteBuilder::RoutePtr& route = source_ ? source_->route_ : route_;
+    if (!route) {
         builder.StartDict()
                 .Key("error_message"s).Value("not found"s)
                 .Key("request_id"s).Value(id_)
@@ -82,35 +117,156 @@ void RoutingStatRequest::Print(json::Builder& builder) const {
         return;
     }
 
-    builder.StartDict().Key("items"s).StartArray();
-
-    for (const auto& item : route_->items) {
-        switch (item.item_type) {
-            case Item::Type::kWait :
-                builder.StartDict()
-                        .Key("type"s).Value("Wait"s)
-                        .Key("time"s).Value(item.time)
-                        .Key("stop_name"s).Value(std::string(item.name))
-                        .EndDict();
-                break;
-            case Item::Type::kBus:
-                builder.StartDict()
-                        .Key("type"s).Value("Bus"s)
-                        .Key("span_count"s).Value(item.span_count)
-                        .Key("time"s).Value(item.time)
-                        .Key("bus"s).Value(std::string(item.name))
-                        .EndDict();
-        }
+    builder.StartDict().Key("items"s);
+    PrintRouteItems(builder, *route);
+    builder.Key("request_id"s).Value(id_)
+            .Key("total_time"s).Value(route->total_time)
+            .EndDict();
+}
+
+void ParetoRouteStatRequest::Evaluate() {
+    routes_ = raptor_.GetParetoRoutes(from_, to_);
+}
+
+void ParetoRouteStatRequest::Print(json::Builder& builder) const {
+    if (routes_.empty()) {
+        builder.StartDict()
+                .Key("error_message"s).Value("not found"s)
+                .Key("request_id"s).Value(id_)
+                .EndDict();
+        return;
     }
 
-    builder.EndArray()
+    builder.StartDict()
             .Key("request_id"s).Value(id_)
-            .Key("total_time"s).Value(route_->total_time)
-            .EndDict();
+            .Key("routes"s).StartArray();
+
+    for (const auto& route : routes_) {
+        const auto rides_count = std::count_if(route.items.begin(), route.items.end(), [](const Item& item) {
+            return item.item_type == Item::Type::kBus;
+        });
+
+        builder.StartDict().Key("items"s);
+        PrintRouteItems(builder, route);
+        builder.Key("total_time"s).Value(route.total_time)
+                .Key("transfers"s).Value(static_cast<int>(std::max<long>(rides_count - 1, 0)))
+                .EndDict();
+    }
+
+    builder.EndArray().EndDict();
 }
 
-JsonReader::JsonReader(transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& r)
-        : db_(db), renderer_(r) {}
+void IsochroneStatRequest::Evaluate() {
+    if (route_builder_) {
+        stops_ = route_builder_->GetReachableStops(from_, max_time_);
+    }
+}
+
+void IsochroneStatRequest::Print(json::Builder& builder) const {
+    // Исходная остановка достижима всегда, поэтому пустой ответ означает неизвестную остановку
+    // или отрицательное max_time
+    if (stops_.empty()) {
+        builder.StartDict()
+                .Key("error_message"s).Value("not found"s)
+                .Key("request_id"s).Value(id_)
+                .EndDict();
+        return;
+    }
+
+    builder.StartDict()
+            .Key("request_id"s).Value(id_)
+            .Key("stops"s).StartArray();
+
+    for (const auto& [stop_name, time] : stops_) {
+        builder.StartDict()
+                .Key("stop_name"s).Value(std::string(stop_name))
+                .Key("time"s).Value(time)
+                .EndDict();
+    }
+
+    builder.EndArray().EndDict();
+}
+
+void NearestStopsStatRequest::Evaluate() {
+    stops_ = db_.FindNearestStops(point_, max_count_, max_distance_);
+}
+
+void NearestStopsStatRequest::Print(json::Builder& builder) const {
+    builder.StartDict()
+            .Key("request_id"s).Value(id_)
+            .Key("stops"s).StartArray();
+
+    for (const auto& [stop, distance] : stops_) {
+        builder.StartDict()
+                .Key("stop_name"s).Value(std::string(stop->stop_name))
+                .Key("distance"s).Value(distance)
+                .EndDict();
+    }
+
+    builder.EndArray().EndDict();
+}
+
+void RouteMatrixStatRequest::Evaluate() {
+    routes_ = route_builder_.GetRouteMatrix(from_, to_);
+}
+
+void RouteMatrixStatRequest::Print(json::Builder& builder) const {
+    builder.StartDict()
+            .Key("request_id"s).Value(id_)
+            .Key("total_times"s).StartArray();
+
+    for (const auto& row : routes_) {
+        builder.StartArray();
+        for (const auto& route : row) {
+            if (route) {
+                builder.Value(route->total_time);
+            } else {
+                builder.Value(nullptr);
+            }
+        }
+        builder.EndArray();
+    }
+    builder.EndArray();
+
+    if (with_items_) {
+        builder.Key("items"s).StartArray();
+        for (const auto& row : routes_) {
+            builder.StartArray();
+            for (const auto& route : row) {
+                if (!route) {
+                    builder.Value(nullptr);
+                    continue;
+                }
+
+                builder.StartArray();
+                for (const auto& item : route->items) {
+                    builder.StartArray();
+                    switch (item.item_type) {
+                        case Item::Type::kWait :
+                            builder.Value("Wait"s);
+                            builder.Value(std::string(item.name));
+                            builder.Value(item.time);
+                            break;
+                        case Item::Type::kBus:
+                            builder.Value("Bus"s);
+                            builder.Value(std::string(item.name));
+                            builder.Value(item.span_count);
+                            builder.Value(item.time);
+                    }
+                    builder.EndArray();
+                }
+                builder.EndArray();
+            }
+            builder.EndArray();
+        }
+        builder.EndArray();
+    }
+
+    builder.EndDict();
+}
+
+JsonReader::JsonReader(transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& r, size_t thread_count)
+        : db_(db), renderer_(r), thread_count_(thread_count) {}
 
 void JsonReader::ParseBaseRequests(const json::Node& input_node) {
     vector<tuple<string, int, string>> stop_distance_to_stop;
@@ -132,15 +288,8 @@ void JsonReader::ParseBaseRequests(const json::Node& input_node) {
                 stops.push_back(node_str.AsString());
             }
 
-            if (!map_stops_and_buses.at("is_roundtrip"s).AsBool()) {
-                std::vector<std::string> tmp = {stops.begin(), stops.end() - 1};
-                tmp.insert(tmp.end(), stops.rbegin(), stops.rend());
-                buses_and_stops.push_back({map_stops_and_buses.at("name"s).AsString(), move(tmp),
-                                           map_stops_and_buses.at("is_roundtrip"s).AsBool()});
-            } else {
-                buses_and_stops.push_back({map_stops_and_buses.at("name"s).AsString(), move(stops),
-                                           map_stops_and_buses.at("is_roundtrip"s).AsBool()});
-            }
+            buses_and_stops.push_back({map_stops_and_buses.at("name"s).AsString(), move(stops),
+                                       map_stops_and_buses.at("is_roundtrip"s).AsBool()});
         }
     }
 
@@ -151,32 +300,100 @@ void JsonReader::ParseBaseRequests(const json::Node& input_node) {
     for (auto& [bus, stops, is_roundtrip] : buses_and_stops) {
         db_.AddBus(bus, stops, is_roundtrip);
     }
-}
 
-void JsonReader::ParseStatRequests(const json::Node& input_node, serialization_data::RouteSettings rs) {
-    //const RouteBuilder& route_builder = ParseRoutingSettingsAndGetRouteBuilder(input_node);
+    db_.Freeze();
+}
 
-    const RouteBuilder route_builder(db_, rs.bus_velocity, rs.bus_wait_time);
+void JsonReader::ParseStatRequests(const json::Node& input_node) {
+    // Первый запрос Route для каждой пары остановок; повторы в пакете не вычисляются заново
+    std::map<std::pair<std::string_view, std::string_view>, const RoutingStatRequest*> unique_route_requests;
+    const TransportCatalogue& db = batch_base_->GetCatalogue();
 
     for (auto& map_requests : input_node.AsDict().at("stat_requests").AsArray()) {
         if (map_requests.AsDict().at("type"s) == "Stop"s) {
             requests_data_.push_back(std::make_unique<StopStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
                                                                        map_requests.AsDict().at("name"s).AsString(),
-                                                                       db_));
+                                                                       db));
         } else if (map_requests.AsDict().at("type"s) == "Bus"s) {
             requests_data_.push_back(std::make_unique<BusStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
                                                                        map_requests.AsDict().at("name"s).AsString(),
-                                                                       db_));
+                                                                       db));
         } else if (map_requests.AsDict().at("type"s) == "Map"s) {
             requests_data_.push_back(std::make_unique<MapStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
-                                                                      db_,
+                                                                      db,
                                                                       renderer_));
         } else if (map_requests.AsDict().at("type"s) == "Route"s) {
-            requests_data_.push_back(std::make_unique<RoutingStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
-                    std::move(route_builder.GetRout(map_requests.AsDict().at("from"s).AsString(),
-                                                    map_requests.AsDict().at("to"s).AsString()))));
+            const std::string& from = map_requests.AsDict().at("from"s).AsString();
+            const std::string& to = map_requests.AsDict().at("to"s).AsString();
+            const int id = map_requests.AsDict().at("id"s).AsInt();
+
+            if (const auto it = unique_route_requests.find({from, to}); it != unique_route_requests.end()) {
+                requests_data_.push_back(std::make_unique<RoutingStatRequest>(id, *it->second));
+            } else {
+                auto request = std::make_unique<RoutingStatRequest>(id, from, to, batch_base_->GetRouteBuilder());
+                unique_route_requests[{from, to}] = request.get();
+                requests_data_.push_back(std::move(request));
+            }
+        } else if (map_requests.AsDict().at("type"s) == "RouteMatrix"s) {
+            const auto& request = map_requests.AsDict();
+            std::vector<std::string> from;
+            std::vector<std::string> to;
+            for (const auto& node : request.at("from"s).AsArray()) {
+                from.push_back(node.AsString());
+            }
+            for (const auto& node : request.at("to"s).AsArray()) {
+                to.push_back(node.AsString());
+            }
+            const bool with_items = request.count("with_items"s) && request.at("with_items"s).AsBool();
+
+            requests_data_.push_back(std::make_unique<RouteMatrixStatRequest>(request.at("id"s).AsInt(),
+                                                                              std::move(from),
+                                                                              std::move(to),
+                                                                              with_items,
+                                                                              batch_base_->GetRouteBuilder()));
+        } else if (map_requests.AsDict().at("type"s) == "RoutePareto"s) {
+            requests_data_.push_back(std::make_unique<ParetoRouteStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
+                                                                              map_requests.AsDict().at("from"s).AsString(),
+                                                                              map_requests.AsDict().at("to"s).AsString(),
+                                                                              batch_base_->GetRaptor()));
+        } else if (map_requests.AsDict().at("type"s) == "Isochrone"s) {
+            // При отрицательном max_time ответ известен заранее, и маршрутизатор ради него не строится
+            const double max_time = map_requests.AsDict().at("max_time"s).AsDouble();
+            requests_data_.push_back(std::make_unique<IsochroneStatRequest>(map_requests.AsDict().at("id"s).AsInt(),
+                                                                            map_requests.AsDict().at("from"s).AsString(),
+                                                                            max_time,
+                                                                            max_time >= 0.
+                                                                            ? &batch_base_->GetRouteBuilder()
+                                                                            : nullptr));
+        } else if (map_requests.AsDict().at("type"s) == "NearestStops"s) {
+            const auto& request = map_requests.AsDict();
+            const size_t max_count = request.count("count"s) ? std::max(0, request.at("count"s).AsInt())
+                                                             : std::numeric_limits<size_t>::max();
+            const double max_distance = request.count("radius"s) ? request.at("radius"s).AsDouble()
+                                                                 : std::numeric_limits<double>::infinity();
+
+            requests_data_.push_back(std::make_unique<NearestStopsStatRequest>(request.at("id"s).AsInt(),
+                                                                               geo::Coordinates{request.at("latitude"s).AsDouble(),
+                                                                                                request.at("longitude"s).AsDouble()},
+                                                                               max_count,
+                                                                               max_distance,
+                                                                               db));
         }
     }
+
+    EvaluateStatRequests();
+}
+
+void JsonReader::EvaluateStatRequests() {
+    // Запросы сильно различаются по стоимости, поэтому потоки берут их небольшими блоками
+    static const size_t requests_per_block = 4;
+
+    concurrency::ThreadPool pool(thread_count_);
+    pool.ParallelFor(0, requests_data_.size(), requests_per_block, [this](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            requests_data_[i]->Evaluate();
+        }
+    });
 }
 
 void JsonReader::OutStatRequests(std::ostream& out) {
@@ -241,14 +458,51 @@ renderer::VisualizationSettings JsonReader::ParseRenderSettings(const json::Node
     return vs;
 }
 
+RouterType JsonReader::ParseRouterType(const json::Node& node) {
+    if (node.AsString() == "all_pairs"s) {
+        return RouterType::kAllPairs;
+    } else if (node.AsString() == "dijkstra"s) {
+        return RouterType::kDijkstra;
+    } else if (node.AsString() == "astar"s) {
+        return RouterType::kAStar;
+    } else if (node.AsString() == "raptor"s) {
+        return RouterType::kRaptor;
+    }
+    throw std::invalid_argument("Unknown router type: "s + node.AsString());
+}
+
+GraphModel JsonReader::ParseGraphModel(const json::Node& node) {
+    if (node.AsString() == "pairwise"s) {
+        return GraphModel::kPairwise;
+    } else if (node.AsString() == "linear"s) {
+        return GraphModel::kLinear;
+    }
+    throw std::invalid_argument("Unknown graph model: "s + node.AsString());
+}
+
+WeightType JsonReader::ParseWeightType(const json::Node& node) {
+    if (node.AsString() == "minutes"s) {
+        return WeightType::kMinutes;
+    } else if (node.AsString() == "fixed_point"s) {
+        return WeightType::kFixedPoint;
+    }
+    throw std::invalid_argument("Unknown weight type: "s + node.AsString());
+}
+
+uint32_t JsonReader::ParseRouteCacheSize(const json::Node& node) {
+    const int route_cache_size = node.AsInt();
+    if (route_cache_size < 0) {
+        throw std::invalid_argument("Negative route cache size: "s + std::to_string(route_cache_size));
+    }
+    return static_cast<uint32_t>(route_cache_size);
+}
+
 RouteBuilder JsonReader::ParseRoutingSettingsAndGetRouteBuilder(const json::Node& input_node) {
     auto& render_settings = input_node.AsDict().at("routing_settings"s).AsDict();
 
-    RouteBuilder route_builder(db_,
+    return RouteBuilder(db_,
             render_settings.at("bus_velocity"s).AsDouble(),
             render_settings.at("bus_wait_time"s).AsDouble());
-
-    return route_builder;
 }
 /*
 void JsonReader::ParseJSON(std::istream &input) {
@@ -261,134 +515,199 @@ void JsonReader::ParseJSON(std::istream &input) {
     renderer_.SetVisualizationSettings(std::move(ParseRenderSettings(input_document.GetRoot())));
 }
 */
-std::pair<std::string, serialization_data::SerializationData> JsonReader::ParseJSONtoGetDataForSerialization(std::istream &input) {
-    const json::Document input_document = json::Load(input);
-    const auto& input_node = input_document.GetRoot();
+uint32_t NameRepository::GetId(std::string_view name) {
+    if (const auto it = name_id.find(name); it != name_id.end()) {
+        return it->second;
+    }
 
-    std::unordered_map<std::string_view, uint32_t> name_id;
-    std::unordered_map<uint32_t, std::string> name_rep;
+    const auto id = static_cast<uint32_t>(name_rep.size());
+    name_rep[id] = name;
+    name_id[name_rep[id]] = id;
 
-    serialization_data::SerializationData serialization_data;
+    return id;
+}
 
-    uint32_t counter = 0;
+serialization_data::Stop JsonReader::ParseSerializationStop(const json::Dict& node, NameRepository& names) {
+    serialization_data::Stop stop;
 
-    for (const auto& node : input_node.AsDict().at("base_requests").AsArray()) {
-        auto map_stops_and_buses = node.AsDict();
-        if (map_stops_and_buses.at("type"s) == "Stop") {
-            serialization_data::Stop stop;
-            {// Дополнительное вложение нужно, чтобы убрать переменную name_stop. Так меньше шансов присвоить её, куда-то не туда.
-                string_view name_stop = map_stops_and_buses.at("name"s).AsString();
-
-                if (!name_id.count(name_stop)) {
-                    name_rep[counter] = name_stop;
-                    name_id[name_rep[counter]] = counter;
-                    ++counter;
-                }
+    stop.name = names.GetId(node.at("name"s).AsString());
+    stop.coordinates.lat = node.at("latitude"s).AsDouble();
+    stop.coordinates.lng = node.at("longitude"s).AsDouble();
 
-                stop.name = name_id[name_stop];
-            }
-            stop.coordinates.lat = map_stops_and_buses.at("latitude"s).AsDouble();
-            stop.coordinates.lng = map_stops_and_buses.at("longitude"s).AsDouble();
+    for (const auto& [to_stop, distances] : node.at("road_distances").AsDict()) {
+        stop.road_distances.push_back({names.GetId(to_stop),
+                                       distances.AsInt()});
+    }
 
-            for (const auto& [to_stop, distances] : map_stops_and_buses.at("road_distances").AsDict()) {
-                if (!name_id.count(to_stop)) {
-                    name_rep[counter] = to_stop;
-                    name_id[name_rep[counter]] = counter;
-                    ++counter;
-                }
+    return stop;
+}
 
-                stop.road_distances.push_back({name_id[to_stop],
-                                               distances.AsInt()});
-            }
+serialization_data::Bus JsonReader::ParseSerializationBus(const json::Dict& node, NameRepository& names) {
+    serialization_data::Bus bus;
 
-            serialization_data.stops.push_back(std::move(stop));
-        } else {
-            serialization_data::Bus bus;
-            {
-                string_view name_bus = map_stops_and_buses.at("name"s).AsString();
-                if (!name_id.count(name_bus)) {
-                    name_rep[counter] = name_bus;
-                    name_id[name_rep[counter]] = counter;
-                    ++counter;
-                }
-                bus.name = name_id[name_bus];
-            }
+    bus.name = names.GetId(node.at("name"s).AsString());
 
-            std::vector<uint32_t> stops;
-            for (auto& node_str : map_stops_and_buses.at("stops"s).AsArray()) {
-                string_view name_stop = node_str.AsString();
-                if (!name_id.count(name_stop)) {
-                    name_rep[counter] = name_stop;
-                    name_id[name_rep[counter]] = counter;
-                    ++counter;
-                }
-                stops.push_back(name_id[name_stop]);
-            }
+    std::vector<uint32_t> stops;
+    for (auto& node_str : node.at("stops"s).AsArray()) {
+        stops.push_back(names.GetId(node_str.AsString()));
+    }
 
-            bus.is_roundtrip = map_stops_and_buses.at("is_roundtrip"s).AsBool();
+    bus.is_roundtrip = node.at("is_roundtrip"s).AsBool();
+    // Обратный путь некольцевого автобуса не хранится ни в базе, ни в каталоге
+    bus.stops = std::move(stops);
 
-            if (!bus.is_roundtrip) {
-                std::vector<uint32_t> tmp = {stops.begin(), stops.end() - 1};
-                tmp.insert(tmp.end(), stops.rbegin(), stops.rend());
-                bus.stops = std::move(tmp);
-            } else {
-                bus.stops = std::move(stops);
-            }
-            serialization_data.buses.push_back(std::move(bus));
+    return bus;
+}
+
+std::pair<std::string, serialization_data::SerializationData> JsonReader::ParseJSONtoGetDataForSerialization(std::istream &input) {
+    const json::Document input_document = json::Load(input);
+    const auto& input_node = input_document.GetRoot();
+
+    NameRepository names;
+
+    serialization_data::SerializationData serialization_data;
+
+    for (const auto& node : input_node.AsDict().at("base_requests").AsArray()) {
+        auto map_stops_and_buses = node.AsDict();
+        if (map_stops_and_buses.at("type"s) == "Stop") {
+            serialization_data.stops.push_back(ParseSerializationStop(map_stops_and_buses, names));
+        } else {
+            serialization_data.buses.push_back(ParseSerializationBus(map_stops_and_buses, names));
         }
     }
 
-    std::vector<std::pair<uint32_t, std::string>> tmp{name_rep.begin(), name_rep.end()};
+    std::vector<std::pair<uint32_t, std::string>> tmp{names.name_rep.begin(), names.name_rep.end()};
     serialization_data.name_repository = std::move(tmp);
 
     std::string serialization_setting = input_node.AsDict().at("serialization_settings").AsDict().at("file").AsString();
 
     serialization_data.vs = ParseRenderSettings(input_node);
 
-    auto& render_settings = input_node.AsDict().at("routing_settings"s).AsDict();
-    serialization_data.route_settings.bus_velocity = render_settings.at("bus_velocity"s).AsDouble();
-    serialization_data.route_settings.bus_wait_time = render_settings.at("bus_wait_time"s).AsDouble();
+    auto& routing_settings = input_node.AsDict().at("routing_settings"s).AsDict();
+    serialization_data.route_settings.bus_velocity = routing_settings.at("bus_velocity"s).AsDouble();
+    serialization_data.route_settings.bus_wait_time = routing_settings.at("bus_wait_time"s).AsDouble();
+    if (routing_settings.count("router"s)) {
+        serialization_data.route_settings.router_type = ParseRouterType(routing_settings.at("router"s));
+    }
+    if (routing_settings.count("route_cache_size"s)) {
+        serialization_data.route_settings.route_cache_size = ParseRouteCacheSize(routing_settings.at("route_cache_size"s));
+    }
+    if (routing_settings.count("graph"s)) {
+        serialization_data.route_settings.graph_model = ParseGraphModel(routing_settings.at("graph"s));
+    }
+    if (routing_settings.count("weights"s)) {
+        serialization_data.route_settings.weight_type = ParseWeightType(routing_settings.at("weights"s));
+    }
+
+    // Граф и таблицы маршрутизатора строятся один раз здесь и сохраняются в базу вместе с каталогом
+    FillCatalogue(serialization_data, names.name_rep, db_);
+
+    const auto& rs = serialization_data.route_settings;
+    const RouteBuilder route_builder(db_, rs.bus_velocity, rs.bus_wait_time, rs.router_type, rs.graph_model,
+                                     rs.weight_type, thread_count_, rs.route_cache_size);
+    serialization_data.router_data = route_builder.GetRouterData(names.name_id);
 
     return {serialization_setting, serialization_data};
 }
 
-serialization_data::RouteSettings JsonReader::ParseDeserializeData(serialization_data::SerializationData&& data) {
-    std::unordered_map<uint32_t, std::string> id_names(data.name_repository.begin(), data.name_repository.end());
+std::pair<std::string, serialization_data::SerializationData> JsonReader::ParseJSONtoUpdateSerializationData(std::istream& input) {
+    const json::Document input_document = json::Load(input);
+    const auto& input_node = input_document.GetRoot();
 
-    vector<tuple<string, int, string>> stop_distance_to_stop;
-    std::vector<std::tuple<std::string, std::vector<std::string>, bool>> buses_and_stops;
+    std::string serialization_setting = input_node.AsDict().at("serialization_settings").AsDict().at("file").AsString();
 
-    for (auto& [name, coord, r_d] : data.stops) {
-        db_.AddStop({id_names[name],
-                     coord.lat,
-                     coord.lng});
-        for (auto [to_stop, distances] : r_d) {
-            stop_distance_to_stop.push_back({id_names[name], distances, id_names[to_stop]});
-        }
+    serialization_data::SerializationData serialization_data = Deserialize(serialization_setting);
+
+    NameRepository names;
+    for (auto& [id, name] : serialization_data.name_repository) {
+        names.name_rep[id] = std::move(name);
+        names.name_id[names.name_rep[id]] = id;
     }
 
-    for (auto& [name, stops_id, is_roundtrip] : data.buses) {
-        vector<string> stops;
-        for (auto& node_str : stops_id) {
-            stops.push_back(id_names[node_str]);
-        }
+    auto& stops = serialization_data.stops;
+    auto& buses = serialization_data.buses;
 
-        buses_and_stops.push_back({id_names[name], move(stops), is_roundtrip});
-    }
+    for (const auto& node : input_node.AsDict().at("base_requests").AsArray()) {
+        const auto& request = node.AsDict();
+
+        if (request.at("type"s) == "Stop"s) {
+            serialization_data::Stop stop = ParseSerializationStop(request, names);
+            const auto it = std::find_if(stops.begin(), stops.end(), [&stop](const auto& other) {
+                return other.name == stop.name;
+            });
+            if (it == stops.end()) {
+                stops.push_back(std::move(stop));
+                continue;
+            }
 
-    for (auto& sds : stop_distance_to_stop) {
-        db_.SetDistanceBetweenStops(sds);
+            // Расстояния существующей остановки обновляются по одному, незатронутые сохраняются
+            it->coordinates = stop.coordinates;
+            for (const auto& road_distance : stop.road_distances) {
+                const auto distance_it = std::find_if(it->road_distances.begin(), it->road_distances.end(),
+                                                      [&road_distance](const auto& other) {
+                    return other.name_stop_to == road_distance.name_stop_to;
+                });
+                if (distance_it == it->road_distances.end()) {
+                    it->road_distances.push_back(road_distance);
+                } else {
+                    distance_it->distances = road_distance.distances;
+                }
+            }
+        } else if (request.at("type"s) == "Bus"s) {
+            serialization_data::Bus bus = ParseSerializationBus(request, names);
+            const auto it = std::find_if(buses.begin(), buses.end(), [&bus](const auto& other) {
+                return other.name == bus.name;
+            });
+            if (it == buses.end()) {
+                buses.push_back(std::move(bus));
+            } else {
+                *it = std::move(bus);
+            }
+        } else if (request.at("type"s) == "RemoveBus"s) {
+            const uint32_t name = names.GetId(request.at("name"s).AsString());
+            buses.erase(std::remove_if(buses.begin(), buses.end(), [name](const auto& bus) {
+                return bus.name == name;
+            }), buses.end());
+        }
     }
 
-    for (auto& [bus, stops, is_roundtrip] : buses_and_stops) {
-        db_.AddBus(bus, stops, is_roundtrip);
-    }
+    serialization_data.name_repository.assign(names.name_rep.begin(), names.name_rep.end());
 
-    renderer_.SetVisualizationSettings(std::move(data.vs));
+    FillCatalogue(serialization_data, names.name_rep, db_);
 
-    serialization_data::RouteSettings rs = data.route_settings;
+    const auto& rs = serialization_data.route_settings;
+    const RouteBuilder route_builder(db_, rs.bus_velocity, rs.bus_wait_time, rs.router_type, rs.graph_model,
+                                     rs.weight_type, std::move(serialization_data.router_data), names.name_id, thread_count_,
+                                     rs.route_cache_size);
+    serialization_data.router_data = route_builder.GetRouterData(names.name_id);
 
-    return rs;
+    return {serialization_setting, std::move(serialization_data)};
+}
+
+transport_catalogue::BaseSnapshotPtr JsonReader::AcquireBase(const std::filesystem::path& base_file) {
+    auto base = base_versions_.Acquire();
+    if (!base || base->GetBaseFile() != base_file) {
+        // Без другой базы на пакет не ответить, поэтому её загрузка ждётся
+        return base_versions_.Load(base_file);
+    }
+
+    // Если файл базы удалили или он недоступен, пакеты обслуживает прежняя версия
+    std::error_code error;
+    const auto write_time = std::filesystem::last_write_time(base_file, error);
+    if (!error && !pending_reload_.valid() && write_time != base->GetBaseWriteTime()) {
+        pending_reload_ = base_versions_.LoadAsync(base_file);
+    }
+    if (pending_reload_.valid() && pending_reload_.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        try {
+            pending_reload_.get();
+        } catch (const std::exception&) {
+            // Новая версия не загрузилась, например файл удалили во время чтения. Пакеты обслуживает прежняя версия,
+            // а загрузка повторится со следующим пакетом, пока время изменения файла отличается
+        }
+        base = base_versions_.Acquire();
+    }
+
+    return base;
 }
 
 void JsonReader::ParseJsonProcessRequests(std::istream &input) {
@@ -397,7 +716,12 @@ void JsonReader::ParseJsonProcessRequests(std::istream &input) {
 
     std::string serialization_setting = input_node.AsDict().at("serialization_settings").AsDict().at("file").AsString();
 
-    auto rs = ParseDeserializeData(std::move(Deserialize(serialization_setting)));
+    // Ответы прошлого пакета уже выведены, и его версия базы больше не нужна
+    requests_data_.clear();
+    batch_base_ = AcquireBase(serialization_setting);
 
-    this->ParseStatRequests(input_document.GetRoot(), rs);
+    renderer::VisualizationSettings vs = batch_base_->GetVisualizationSettings();
+    renderer_.SetVisualizationSettings(std::move(vs));
+
+    this->ParseStatRequests(input_document.GetRoot());
 }
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "transport_catalogue.h"
+#include "base_snapshot.h"
 #include "json.h"
 #include "svg.h"
 #include "map_renderer.h"
 #include "transport_router.h"
 #include "json_builder.h"
+#include "thread_pool.h"
 
+#include <future>
 #include <sstream>
 #include "request_handler.h"
 
@@ -22,12 +25,19 @@ public:
     : id_(id) {
     }
 
+    // Вычисляет ответ заранее. Разные запросы вычисляются параллельно, поэтому Evaluate только читает
+    // каталог и маршрутизатор; запросы с изменяемым состоянием (Map) выполняют работу в Print
+    virtual void Evaluate() {
+    }
+
+    // Выводит ответ; вызывается последовательно в порядке запросов
     virtual void Print(json::Builder& builder) const = 0;
 };
 
 class BusStatRequest : public StatRequestData {
     std::string route_name_;
     const transport_catalogue::TransportCatalogue& db_;
+    std::optional<transport_catalogue::BusInfo> bus_info_;
 public:
     BusStatRequest(int id, const std::string& name, const transport_catalogue::TransportCatalogue& db)
             : StatRequestData(id), route_name_(name), db_(db) {
@@ -36,6 +46,8 @@ public:
             : StatRequestData(id), route_name_(std::move(name)), db_(db) {
     }
 
+    void Evaluate() override;
+
     void Print(json::Builder& builder) const override;
 };
 
@@ -43,8 +55,7 @@ class StopStatRequest : public StatRequestData {
     using StatRequestData = StatRequestData;
     std::string stop_name_;
     const transport_catalogue::TransportCatalogue& db_;
-
-    json::Array GetBusNames(const std::unordered_set<transport_catalogue::Bus*>* stop_buses) const;
+    std::optional<json::Array> bus_names_;
 
 public:
     StopStatRequest(int id, const std::string& name, const transport_catalogue::TransportCatalogue& db)
@@ -54,6 +65,8 @@ public:
     : StatRequestData(id), stop_name_(std::move(name)), db_(db) {
     }
 
+    void Evaluate() override;
+
     void Print(json::Builder& builder) const override;
 };
 
@@ -62,7 +75,7 @@ class MapStatRequest : public StatRequestData {
     renderer::MapRenderer& renderer_;
 
 public:
-    MapStatRequest(int id, transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& renderer)
+    MapStatRequest(int id, const transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& renderer)
     : StatRequestData(id), db_(db), renderer_(renderer) {
     }
 
@@ -70,21 +83,115 @@ public:
 };
 
 class RoutingStatRequest : public StatRequestData {
-    std::optional<Route> route_;
+    std::string from_;
+    std::string to_;
+    const RouteBuilder& route_builder_;
+    // Повтор запроса с той же парой остановок в пакете берёт ответ у первого такого запроса
+    const RoutingStatRequest* source_ = nullptr;
+    RouteBuilder::RoutePtr route_;
 
 public:
-    RoutingStatRequest(int id, std::optional<Route> route)
-    : StatRequestData(id), route_(std::move(route)) {
+    RoutingStatRequest(int id, std::string from, std::string to, const RouteBuilder& route_builder)
+    : StatRequestData(id), from_(std::move(from)), to_(std::move(to)), route_builder_(route_builder) {
+    }
+    RoutingStatRequest(int id, const RoutingStatRequest& source)
+    : StatRequestData(id), route_builder_(source.route_builder_), source_(&source) {
     }
 
+    void Evaluate() override;
+
     void Print(json::Builder& builder) const override;
 };
 
+// Матрица маршрутов: total_times[i][j] — время от from[i] до to[j] или null, если маршрута нет.
+// С with_items ячейка items[i][j] — компактный список элементов: ["Wait", остановка, время] и ["Bus", автобус, span_count, время]
+class RouteMatrixStatRequest : public StatRequestData {
+    std::vector<std::string> from_;
+    std::vector<std::string> to_;
+    bool with_items_;
+    const RouteBuilder& route_builder_;
+    std::vector<std::vector<std::optional<Route>>> routes_;
+
+public:
+    RouteMatrixStatRequest(int id, std::vector<std::string> from, std::vector<std::string> to, bool with_items,
+                           const RouteBuilder& route_builder)
+    : StatRequestData(id), from_(std::move(from)), to_(std::move(to)), with_items_(with_items), route_builder_(route_builder) {
+    }
+
+    void Evaluate() override;
+
+    void Print(json::Builder& builder) const override;
+};
 
+// Маршруты, оптимальные по Парето по времени и числу пересадок: routes — в порядке возрастания пересадок,
+// у каждого items в формате запроса Route, total_time и transfers
+class ParetoRouteStatRequest : public StatRequestData {
+    std::string from_;
+    std::string to_;
+    const transit::RaptorRouter& raptor_;
+    std::vector<Route> routes_;
+
+public:
+    ParetoRouteStatRequest(int id, std::string from, std::string to, const transit::RaptorRouter& raptor)
+    : StatRequestData(id), from_(std::move(from)), to_(std::move(to)), raptor_(raptor) {
+    }
+
+    void Evaluate() override;
+
+    void Print(json::Builder& builder) const override;
+};
+
+// Изохрона: остановки, до которых можно доехать из from не дольше чем за max_time минут.
+// stops — в порядке возрастания времени, у каждой stop_name и time
+class IsochroneStatRequest : public StatRequestData {
+    std::string from_;
+    double max_time_;
+    // nullptr, если max_time отрицательно или NaN: такой запрос сразу отвечает not found
+    const RouteBuilder* route_builder_;
+    std::vector<std::pair<std::string_view, double>> stops_;
+
+public:
+    IsochroneStatRequest(int id, std::string from, double max_time, const RouteBuilder* route_builder)
+    : StatRequestData(id), from_(std::move(from)), max_time_(max_time), route_builder_(route_builder) {
+    }
+
+    void Evaluate() override;
+
+    void Print(json::Builder& builder) const override;
+};
+
+// Остановки рядом с точкой: не больше count ближайших к (latitude, longitude) не дальше radius метров;
+// без count и radius — все остановки. stops — по возрастанию расстояния, у каждой stop_name и distance в метрах
+class NearestStopsStatRequest : public StatRequestData {
+    geo::Coordinates point_;
+    size_t max_count_;
+    double max_distance_;
+    const transport_catalogue::TransportCatalogue& db_;
+    std::vector<transport_catalogue::NearbyStop> stops_;
+
+public:
+    NearestStopsStatRequest(int id, geo::Coordinates point, size_t max_count, double max_distance,
+                            const transport_catalogue::TransportCatalogue& db)
+    : StatRequestData(id), point_(point), max_count_(max_count), max_distance_(max_distance), db_(db) {
+    }
+
+    void Evaluate() override;
+
+    void Print(json::Builder& builder) const override;
+};
+
+// Названия объектов базы и их идентификаторы; name_id ссылается на строки name_rep
+struct NameRepository {
+    std::unordered_map<std::string_view, uint32_t> name_id;
+    std::unordered_map<uint32_t, std::string> name_rep;
+
+    // Идентификатор названия; для нового названия выдаётся следующий свободный
+    uint32_t GetId(std::string_view name);
+};
 
 class JsonReader {
 public:
-    JsonReader(transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& r);
+    JsonReader(transport_catalogue::TransportCatalogue& db, renderer::MapRenderer& r, size_t thread_count = 1);
 
     //void ParseJSON(std::istream &input);
 
@@ -92,6 +199,15 @@ public:
 
     std::pair<std::string, serialization_data::SerializationData> ParseJSONtoGetDataForSerialization(std::istream &input);
 
+    // Применяет к сохранённой базе изменения из base_requests: Stop и Bus добавляют или заменяют объекты,
+    // RemoveBus удаляет маршрут. Таблица маршрутизатора по возможности обновляется, а не строится заново
+    std::pair<std::string, serialization_data::SerializationData> ParseJSONtoUpdateSerializationData(std::istream& input);
+
+    // Обрабатывает пакет запросов. Один объект JsonReader может обработать несколько пакетов подряд:
+    // база загружается при первом пакете, а маршрутизатор строится при первом запросе Route или RouteMatrix
+    // и используется следующими пакетами. Пакет со ссылкой на другой файл базы ждёт её загрузки;
+    // если файл текущей базы перезаписан, новая версия загружается в фоне, а пакеты до её готовности
+    // обслуживает прежняя
     void ParseJsonProcessRequests(std::istream &input);
 
 private:
@@ -99,17 +215,46 @@ private:
 
     renderer::MapRenderer& renderer_;
 
+    const size_t thread_count_;
+
     std::vector<std::unique_ptr<StatRequestData>> requests_data_;
 
+    // Версии базы для process_requests; db_ в этом режиме не используется
+    transport_catalogue::BaseVersions base_versions_;
+
+    // Версия, по которой отвечает текущий пакет; запросы пакета ссылаются в неё
+    transport_catalogue::BaseSnapshotPtr batch_base_;
+
+    // Фоновая загрузка перезаписанного файла базы. Объявлена после base_versions_, чтобы при разрушении
+    // дождаться загрузки раньше, чем будут разрушены версии
+    std::future<transport_catalogue::BaseSnapshotPtr> pending_reload_;
+
     void ParseBaseRequests(const json::Node& input_node);
 
-    void ParseStatRequests(const json::Node& input_node, serialization_data::RouteSettings rs);
+    void ParseStatRequests(const json::Node& input_node);
+
+    // Вычисляет ответы на запросы на пуле из thread_count_ потоков; порядок вывода не меняется
+    void EvaluateStatRequests();
 
     renderer::VisualizationSettings ParseRenderSettings(const json::Node& input_node);
 
     svg::Color GetColor(const json::Node& node);
 
+    RouterType ParseRouterType(const json::Node& node);
+
+    GraphModel ParseGraphModel(const json::Node& node);
+
+    WeightType ParseWeightType(const json::Node& node);
+
+    // Размер кеша маршрутов; отрицательный размер — ошибка
+    uint32_t ParseRouteCacheSize(const json::Node& node);
+
     RouteBuilder ParseRoutingSettingsAndGetRouteBuilder(const json::Node& input_node);
 
-    serialization_data::RouteSettings ParseDeserializeData(serialization_data::SerializationData&& data);
+    serialization_data::Stop ParseSerializationStop(const json::Dict& node, NameRepository& names);
+
+    serialization_data::Bus ParseSerializationBus(const json::Dict& node, NameRepository& names);
+
+    // Версия базы для пакета со ссылкой на base_file
+    transport_catalogue::BaseSnapshotPtr AcquireBase(const std::filesystem::path& base_file);
 };
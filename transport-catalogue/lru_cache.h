@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+
+// lru_cache — ограниченный по числу записей кеш, вытесняющий давно не использованные записи.
+// LruCache не потокобезопасен: при общем доступе из нескольких потоков его защищает владелец.
+// ShardedLruCache — потокобезопасный кеш из нескольких LruCache под своими мьютексами
+
+namespace cache {
+
+    struct CacheStats {
+        size_t hits = 0;
+        size_t misses = 0;
+    };
+
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache {
+    public:
+        // При capacity == 0 кеш ничего не хранит, но промахи по-прежнему подсчитываются
+        explicit LruCache(size_t capacity)
+        : capacity_(capacity) {
+        }
+
+        // Возвращает значение и делает запись самой свежей
+        std::optional<Value> Get(const Key& key) {
+            const auto it = index_.find(key);
+            if (it == index_.end()) {
+                ++stats_.misses;
+                return std::nullopt;
+            }
+
+            ++stats_.hits;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->second;
+        }
+
+        void Put(const Key& key, Value value) {
+            if (capacity_ == 0) {
+                return;
+            }
+
+            if (const auto it = index_.find(key); it != index_.end()) {
+                it->second->second = std::move(value);
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return;
+            }
+
+            if (entries_.size() == capacity_) {
+                index_.erase(entries_.back().first);
+                entries_.pop_back();
+            }
+            entries_.emplace_front(key, std::move(value));
+            index_[key] = entries_.begin();
+        }
+
+        size_t GetSize() const {
+            return entries_.size();
+        }
+
+        const CacheStats& GetStats() const {
+            return stats_;
+        }
+
+    private:
+        using Entries = std::list<std::pair<Key, Value>>;
+
+        size_t capacity_;
+        // Записи от самой свежей к самой старой
+        Entries entries_;
+        std::unordered_map<Key, typename Entries::iterator, Hash> index_;
+        CacheStats stats_;
+    };
+
+    // Записи распределяются по сегментам по хешу ключа, и каждый сегмент вытесняет записи сам.
+    // Потоки, обращающиеся к разным сегментам, друг друга не ждут
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class ShardedLruCache {
+    public:
+        static constexpr size_t SHARD_COUNT = 16;
+
+        // Ёмкость делится между сегментами с округлением вверх
+        explicit ShardedLruCache(size_t capacity) {
+            for (size_t i = 0; i < SHARD_COUNT; ++i) {
+                shards_.emplace_back((capacity + SHARD_COUNT - 1) / SHARD_COUNT);
+            }
+        }
+
+        std::optional<Value> Get(const Key& key) {
+            Shard& shard = GetShard(key);
+            std::lock_guard lock(shard.mutex);
+            return shard.cache.Get(key);
+        }
+
+        void Put(const Key& key, Value value) {
+            Shard& shard = GetShard(key);
+            std::lock_guard lock(shard.mutex);
+            shard.cache.Put(key, std::move(value));
+        }
+
+        CacheStats GetStats() const {
+            CacheStats stats;
+            for (const Shard& shard : shards_) {
+                std::lock_guard lock(shard.mutex);
+                stats.hits += shard.cache.GetStats().hits;
+                stats.misses += shard.cache.GetStats().misses;
+            }
+            return stats;
+        }
+
+    private:
+        struct Shard {
+            explicit Shard(size_t capacity)
+            : cache(capacity) {
+            }
+
+            mutable std::mutex mutex;
+            LruCache<Key, Value, Hash> cache;
+        };
+
+        // Сегменты не перемещаются, поэтому мьютексы лежат в deque
+        std::deque<Shard> shards_;
+
+        Shard& GetShard(const Key& key) {
+            // Хеш целых чисел в libstdc++ тождественный, поэтому биты перемешиваются умножением
+            const uint64_t hash = static_cast<uint64_t>(Hash{}(key)) * 0x9E3779B97F4A7C15ull;
+            return shards_[(hash >> 32) % SHARD_COUNT];
+        }
+    };
+}
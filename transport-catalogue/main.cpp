@@ -2,43 +2,93 @@
 #include "serialization.h"
 #include "json_reader.h"
 #include "map_renderer.h"
+#include "thread_pool.h"
 
 #include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
 #include <string_view>
 
 using namespace std::literals;
 
 void PrintUsage(std::ostream& stream = std::cerr) {
-    stream << "Usage: transport_catalogue [make_base|process_requests]\n"sv;
+    stream << "Usage: transport_catalogue [make_base|update_base|process_requests] [--threads N]\n"sv;
+}
+
+// Разбирает необязательные параметры после режима работы. Сейчас поддерживается только --threads N
+std::optional<size_t> ParseThreadCount(int argc, char* argv[]) {
+    if (argc == 2) {
+        return concurrency::GetDefaultThreadCount();
+    }
+    if (argc != 4 || argv[2] != "--threads"sv) {
+        return std::nullopt;
+    }
+
+    try {
+        const long long thread_count = std::stoll(argv[3]);
+        if (thread_count < 1) {
+            return std::nullopt;
+        }
+        return static_cast<size_t>(thread_count);
+    } catch (const std::exception&) {
+        return std::nullopt;
+    }
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    if (argc < 2) {
         PrintUsage();
         return 1;
     }
 
     const std::string_view mode(argv[1]);
 
+    const std::optional<size_t> thread_count = ParseThreadCount(argc, argv);
+    if (!thread_count) {
+        PrintUsage();
+        return 1;
+    }
+
     if (mode == "make_base"sv) {
 
         transport_catalogue::TransportCatalogue db;
         renderer::MapRenderer mr;
 
-        JsonReader json_reader(db, mr);
+        JsonReader json_reader(db, mr, *thread_count);
 
         auto [serialization_setting, serialization_data] = json_reader.ParseJSONtoGetDataForSerialization(std::cin);
         Serialize(serialization_setting,  std::move(serialization_data));
 
+    } else if (mode == "update_base"sv) {
+
+        transport_catalogue::TransportCatalogue db;
+        renderer::MapRenderer mr;
+
+        JsonReader json_reader(db, mr, *thread_count);
+
+        auto [serialization_setting, serialization_data] = json_reader.ParseJSONtoUpdateSerializationData(std::cin);
+        Serialize(serialization_setting,  std::move(serialization_data));
+
     } else if (mode == "process_requests"sv) {
 
         transport_catalogue::TransportCatalogue db;
         renderer::MapRenderer mr;
 
-        JsonReader json_reader(db, mr);
-        json_reader.ParseJsonProcessRequests(std::cin);
-        json_reader.OutStatRequests(std::cout);
+        JsonReader json_reader(db, mr, *thread_count);
+
+        // Пакеты запросов идут подряд; ответы на них выводятся в том же порядке, по массиву на строку
+        bool is_first_batch = true;
+        while (std::cin >> std::ws && std::cin.peek() != std::char_traits<char>::eof()) {
+            if (!is_first_batch) {
+                std::cout << '\n';
+            }
+            is_first_batch = false;
+
+            json_reader.ParseJsonProcessRequests(std::cin);
+            json_reader.OutStatRequests(std::cout);
+            std::cout.flush();
+        }
 
     } else {
         PrintUsage();
@@ -34,25 +34,27 @@ namespace renderer {
         auto it_color_palette = vs_.color_palette.begin();
 
         for (const auto bus : buses) {
-            if (bus->stops.empty()) {
+            const RouteView route = bus->GetRoute();
+            if (route.empty()) {
                 continue;
             }
 
             std::vector<svg::Point> coords;
-            for (auto stop : bus->stops) {
+            coords.reserve(route.size());
+            for (auto stop : route) {
                 coords.push_back(proj(stop->coordinates));
             }
             route_lines.emplace_back(make_unique<Route>(std::move(coords), vs_.line_width, *it_color_palette));
 
             RouteNameData route_name_data;
-            route_name_data.route_name = bus->bus_name;
+            route_name_data.route_name = std::string(bus->bus_name);
             route_name_data.route_color = *it_color_palette;
-            route_name_data.position = proj(bus->stops.front()->coordinates);
+            route_name_data.position = proj(route.front()->coordinates);
             route_name_text.emplace_back(make_unique<RouteName>(route_name_data, vs_));
 
-            size_t terminus = bus->stops.size() / 2;
-            if (!bus->is_roundtrip && bus->stops[terminus] != bus->stops.front()) {
-                route_name_data.position = proj(bus->stops[terminus]->coordinates);
+            size_t terminus = route.size() / 2;
+            if (!bus->is_roundtrip && route[terminus] != route.front()) {
+                route_name_data.position = proj(route[terminus]->coordinates);
                 route_name_text.emplace_back(make_unique<RouteName>(route_name_data, vs_));
             }
 
@@ -69,6 +71,9 @@ namespace renderer {
                              const std::vector<const Stop*>& stops,
                              const std::vector<geo::Coordinates>& geo_coords,
                              std::ostream& out) {
+        // Каждый запрос Map рисует карту заново, а не поверх предыдущей
+        doc_.Clear();
+
         const SphereProjector proj{
                 geo_coords.begin(), geo_coords.end(), vs_.width, vs_.height, vs_.padding
         };
@@ -80,7 +85,7 @@ namespace renderer {
 
         for (const auto stop : stops) {
             stops_symbols.emplace_back(make_unique<StopSymbol>(proj(stop->coordinates), vs_.stop_radius));
-            stops_names.emplace_back(make_unique<StopName>(stop->stop_name, proj(stop->coordinates), vs_));
+            stops_names.emplace_back(make_unique<StopName>(std::string(stop->stop_name), proj(stop->coordinates), vs_));
         }
 
         DrawPicture(stops_symbols, doc_);
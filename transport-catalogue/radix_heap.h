@@ -0,0 +1,139 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// radix_heap — очереди с приоритетом для поиска кратчайших путей
+
+namespace graph {
+
+    // Монотонная очередь для беззнаковых целых ключей: ключ добавляемого элемента не меньше последнего извлечённого.
+    // Элемент лежит в корзине с номером старшего бита, которым его ключ отличается от последнего извлечённого,
+    // и за всё время переходит между корзинами не больше разрядности ключа раз. Поэтому добавление — O(1),
+    // а извлечение — амортизированно O(разрядность) без сравнений элементов между собой
+    template <typename Key, typename Value>
+    class RadixHeap {
+        static_assert(std::is_integral_v<Key> && std::is_unsigned_v<Key>, "RadixHeap keys should be unsigned integers");
+
+    public:
+        bool IsEmpty() const {
+            return size_ == 0;
+        }
+
+        size_t GetSize() const {
+            return size_;
+        }
+
+        void Push(Key key, Value value) {
+            assert(key >= last_key_);
+            buckets_[GetBucketIndex(key)].emplace_back(key, std::move(value));
+            ++size_;
+        }
+
+        // Извлекает элемент с наименьшим ключом; очередь не должна быть пустой
+        std::pair<Key, Value> Pop() {
+            assert(!IsEmpty());
+            if (buckets_[0].empty()) {
+                Redistribute();
+            }
+
+            auto item = std::move(buckets_[0].back());
+            buckets_[0].pop_back();
+            --size_;
+            return item;
+        }
+
+    private:
+        using Bucket = std::vector<std::pair<Key, Value>>;
+
+        static constexpr size_t BUCKETS_COUNT = std::numeric_limits<Key>::digits + 1;
+
+        Bucket buckets_[BUCKETS_COUNT];
+        Key last_key_ = 0;
+        size_t size_ = 0;
+
+        static size_t GetBitWidth(Key value) {
+#if defined(__GNUC__) || defined(__clang__)
+            return value == 0 ? 0 : std::numeric_limits<unsigned long long>::digits
+                                    - __builtin_clzll(static_cast<unsigned long long>(value));
+#else
+            size_t width = 0;
+            for (; value != 0; value >>= 1) {
+                ++width;
+            }
+            return width;
+#endif
+        }
+
+        size_t GetBucketIndex(Key key) const {
+            return GetBitWidth(key ^ last_key_);
+        }
+
+        // Переносит элементы первой непустой корзины в младшие, сделав наименьший из них последним извлечённым ключом
+        void Redistribute() {
+            size_t index = 1;
+            while (buckets_[index].empty()) {
+                ++index;
+            }
+
+            Bucket bucket = std::move(buckets_[index]);
+            buckets_[index].clear();
+
+            last_key_ = bucket.front().first;
+            for (const auto& [key, value] : bucket) {
+                last_key_ = std::min(last_key_, key);
+            }
+            for (auto& item : bucket) {
+                buckets_[GetBucketIndex(item.first)].push_back(std::move(item));
+            }
+        }
+    };
+
+    // Двоичная куча с тем же интерфейсом; элементы сравниваются только по ключу
+    template <typename Key, typename Value>
+    class BinaryHeap {
+    public:
+        bool IsEmpty() const {
+            return queue_.empty();
+        }
+
+        size_t GetSize() const {
+            return queue_.size();
+        }
+
+        void Push(Key key, Value value) {
+            queue_.push({key, std::move(value)});
+        }
+
+        std::pair<Key, Value> Pop() {
+            Item item = queue_.top();
+            queue_.pop();
+            return {item.key, std::move(item.value)};
+        }
+
+    private:
+        struct Item {
+            Key key;
+            Value value;
+
+            bool operator>(const Item& other) const {
+                return key > other.key;
+            }
+        };
+
+        std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue_;
+    };
+
+    // Очередь поиска Дейкстры: для целых беззнаковых весов — RadixHeap, для остальных — двоичная куча
+    template <typename Weight, typename Value>
+    using SearchQueue = std::conditional_t<std::is_integral_v<Weight> && std::is_unsigned_v<Weight>,
+                                           RadixHeap<Weight, Value>,
+                                           BinaryHeap<Weight, Value>>;
+}
@@ -0,0 +1,251 @@
+#include "raptor.h"
+
+#include <algorithm>
+
+namespace transit {
+
+    RaptorRouter::RaptorRouter(const transport_catalogue::TransportCatalogue& db, double bus_velocity,
+                               double bus_wait_time)
+            : bus_velocity_(bus_velocity), bus_wait_time_(bus_wait_time), db_(db) {
+        // Рейсы делятся так же, как в графе маршрутов: пересадка в точке разворота требует нового ожидания
+        for (const auto* bus : db.GetBuses()) {
+            const size_t route_size = bus->GetRoute().size();
+            if (route_size == 0) {
+                continue;
+            }
+            if (!bus->is_roundtrip) {
+                AddPattern(db, *bus, 0, (route_size / 2) + 1);
+                AddPattern(db, *bus, route_size / 2, route_size);
+            } else {
+                AddPattern(db, *bus, 0, route_size);
+            }
+        }
+
+        BuildStopPositions();
+    }
+
+    void RaptorRouter::AddPattern(const transport_catalogue::TransportCatalogue& db,
+                                  const transport_catalogue::Bus& bus, size_t begin, size_t end) {
+        const auto pattern_begin = static_cast<uint32_t>(pattern_stops_.size());
+        const transport_catalogue::RouteView route = bus.GetRoute();
+
+        for (size_t i = begin; i < end; ++i) {
+            pattern_stops_.push_back(route[i]->id);
+
+            const double distance = i == begin
+                                    ? 0.
+                                    : pattern_distances_.back() + db.GetRoadDistance(route[i - 1]->id, route[i]->id).value();
+            pattern_distances_.push_back(distance);
+            pattern_times_.push_back(CalculateTravelTime(distance));
+        }
+
+        patterns_.push_back({pattern_begin, static_cast<uint32_t>(pattern_stops_.size()), bus.bus_name});
+    }
+
+    void RaptorRouter::BuildStopPositions() {
+        const size_t stops_count = db_.GetStopsCount();
+        stop_positions_offsets_.assign(stops_count + 1, 0);
+        for (const uint32_t stop : pattern_stops_) {
+            ++stop_positions_offsets_[stop + 1];
+        }
+        for (size_t stop = 0; stop < stops_count; ++stop) {
+            stop_positions_offsets_[stop + 1] += stop_positions_offsets_[stop];
+        }
+
+        stop_positions_.resize(pattern_stops_.size());
+        std::vector<uint32_t> next(stop_positions_offsets_.begin(), stop_positions_offsets_.end() - 1);
+        for (uint32_t pattern = 0; pattern < patterns_.size(); ++pattern) {
+            for (uint32_t position = patterns_[pattern].begin; position < patterns_[pattern].end; ++position) {
+                stop_positions_[next[pattern_stops_[position]]++] = {pattern, position};
+            }
+        }
+    }
+
+    double RaptorRouter::CalculateTravelTime(double distance) const {
+        const static double minutes_in_one_hour = 60.;
+        const static double meters_in_one_kilometer = 1000.;
+
+        return (distance * minutes_in_one_hour) / (meters_in_one_kilometer * bus_velocity_);
+    }
+
+    std::optional<uint32_t> RaptorRouter::FindStop(std::string_view stop_name) const {
+        const auto id = db_.FindStopId(stop_name);
+        if (!id || stop_positions_offsets_[*id] == stop_positions_offsets_[*id + 1]) {
+            return std::nullopt;
+        }
+        return *id;
+    }
+
+    RaptorRouter::Profile RaptorRouter::Search(uint32_t from, std::optional<uint32_t> to, double max_arrival) const {
+        const size_t stops_count = db_.GetStopsCount();
+
+        Profile profile{from, {}};
+        profile.rounds.emplace_back(stops_count, Label{UNREACHED, NO_PATTERN, 0, 0});
+        profile.rounds.back().at(from).arrival = 0.;
+
+        // Лучшее время по всем раундам: улучшение засчитывается, только если оно лучше любого прошлого раунда
+        std::vector<double> best_arrivals(stops_count, UNREACHED);
+        best_arrivals[from] = 0.;
+
+        std::vector<uint32_t> marked_stops{from};
+        std::vector<char> is_marked(stops_count, 0);
+        // Первая позиция рейса, с которой его нужно просмотреть в текущем раунде
+        std::vector<uint32_t> scan_begins(patterns_.size(), NO_PATTERN);
+        std::vector<uint32_t> scanned_patterns;
+
+        while (!marked_stops.empty()) {
+            for (const uint32_t stop : marked_stops) {
+                for (uint32_t i = stop_positions_offsets_[stop]; i < stop_positions_offsets_[stop + 1]; ++i) {
+                    const auto [pattern, position] = stop_positions_[i];
+                    if (scan_begins[pattern] == NO_PATTERN) {
+                        scanned_patterns.push_back(pattern);
+                    }
+                    scan_begins[pattern] = std::min(scan_begins[pattern], position);
+                }
+            }
+            marked_stops.clear();
+
+            std::vector<Label> labels;
+            labels.reserve(stops_count);
+            for (const auto& label : profile.rounds.back()) {
+                labels.push_back({label.arrival, NO_PATTERN, 0, 0});
+            }
+            const auto& previous_labels = profile.rounds.back();
+
+            for (const uint32_t pattern : scanned_patterns) {
+                // Время прибытия на позицию рейса — boarding_time + pattern_times_[позиция]
+                bool is_boarded = false;
+                double boarding_time = 0.;
+                uint32_t board_position = 0;
+
+                for (uint32_t position = scan_begins[pattern]; position < patterns_[pattern].end; ++position) {
+                    const uint32_t stop = pattern_stops_[position];
+
+                    if (is_boarded) {
+                        const double arrival = boarding_time + pattern_times_[position];
+                        if (arrival < best_arrivals[stop] && arrival <= max_arrival
+                            && (!to || arrival < best_arrivals[*to])) {
+                            best_arrivals[stop] = arrival;
+                            labels[stop] = {arrival, pattern, board_position, position};
+                            if (!is_marked[stop]) {
+                                is_marked[stop] = 1;
+                                marked_stops.push_back(stop);
+                            }
+                        }
+                    }
+
+                    // Садиться можно только там, куда успели в прошлом раунде
+                    if (previous_labels[stop].arrival != UNREACHED) {
+                        const double candidate = previous_labels[stop].arrival + bus_wait_time_ - pattern_times_[position];
+                        if (!is_boarded || candidate < boarding_time) {
+                            is_boarded = true;
+                            boarding_time = candidate;
+                            board_position = position;
+                        }
+                    }
+                }
+                scan_begins[pattern] = NO_PATTERN;
+            }
+            scanned_patterns.clear();
+
+            for (const uint32_t stop : marked_stops) {
+                is_marked[stop] = 0;
+            }
+            if (!marked_stops.empty()) {
+                profile.rounds.push_back(std::move(labels));
+            }
+        }
+
+        return profile;
+    }
+
+    std::vector<std::pair<std::string_view, double>> RaptorRouter::FindStopsWithinTime(uint32_t from,
+                                                                                       double max_time) const {
+        std::vector<std::pair<std::string_view, double>> stops;
+
+        const Profile profile = Search(from, std::nullopt, max_time);
+        const auto& labels = profile.rounds.back();
+        for (uint32_t stop = 0; stop < labels.size(); ++stop) {
+            if (labels[stop].arrival != UNREACHED) {
+                stops.emplace_back(db_.GetStop(stop).stop_name, labels[stop].arrival);
+            }
+        }
+
+        return stops;
+    }
+
+    RaptorRouter::Journey RaptorRouter::MakeJourney(const Profile& profile, size_t round, uint32_t to) const {
+        Journey journey{profile.rounds[round][to].arrival, {}};
+
+        uint32_t stop = to;
+        for (; round > 0; --round) {
+            const Label& label = profile.rounds[round][stop];
+            if (label.pattern == NO_PATTERN) {
+                continue;
+            }
+
+            journey.legs.push_back({db_.GetStop(pattern_stops_[label.board_position]).stop_name,
+                                    patterns_[label.pattern].bus,
+                                    label.alight_position - label.board_position,
+                                    CalculateTravelTime(pattern_distances_[label.alight_position]
+                                                        - pattern_distances_[label.board_position])});
+            stop = pattern_stops_[label.board_position];
+        }
+        std::reverse(journey.legs.begin(), journey.legs.end());
+
+        return journey;
+    }
+
+    std::optional<RaptorRouter::Journey> RaptorRouter::GetJourney(const Profile& profile, uint32_t to) const {
+        const size_t last_round = profile.rounds.size() - 1;
+        if (profile.rounds[last_round].at(to).arrival == UNREACHED) {
+            return std::nullopt;
+        }
+
+        return MakeJourney(profile, last_round, to);
+    }
+
+    std::vector<RaptorRouter::Journey> RaptorRouter::GetParetoJourneys(const Profile& profile, uint32_t to) const {
+        std::vector<Journey> journeys;
+
+        // Время до to меняется только в раундах, где оно улучшилось, поэтому каждый такой раунд — точка Парето
+        for (size_t round = 0; round < profile.rounds.size(); ++round) {
+            const Label& label = profile.rounds[round].at(to);
+            if (label.arrival != UNREACHED && (round == 0 || label.pattern != NO_PATTERN)) {
+                journeys.push_back(MakeJourney(profile, round, to));
+            }
+        }
+
+        return journeys;
+    }
+
+    Route RaptorRouter::MakeRoute(const Journey& journey) const {
+        Route route{journey.total_time, {}};
+
+        route.items.reserve(journey.legs.size() * 2);
+        for (const auto& leg : journey.legs) {
+            route.items.push_back({leg.board_stop, 0, bus_wait_time_, Item::Type::kWait});
+            route.items.push_back({leg.bus, static_cast<int>(leg.span_count), leg.ride_time, Item::Type::kBus});
+        }
+
+        return route;
+    }
+
+    std::vector<Route> RaptorRouter::GetParetoRoutes(std::string_view from, std::string_view to) const {
+        const auto stop_from = FindStop(from);
+        const auto stop_to = FindStop(to);
+        if (!stop_from || !stop_to) {
+            return {};
+        }
+        if (*stop_from == *stop_to) {
+            return {Route{0, {}}};
+        }
+
+        std::vector<Route> routes;
+        for (const auto& journey : GetParetoJourneys(Search(*stop_from, *stop_to), *stop_to)) {
+            routes.push_back(MakeRoute(journey));
+        }
+
+        return routes;
+    }
+}
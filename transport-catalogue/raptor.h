@@ -0,0 +1,117 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "domain.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// raptor — поиск маршрутов по раундам прямо по последовательностям остановок автобусов, без графа маршрутов.
+// Раунд k находит лучшие времена прибытия на остановки не более чем за k поездок: каждый рейс, на остановке
+// которого в прошлом раунде улучшилось время, один раз просматривается по порядку остановок
+
+namespace transit {
+
+    class RaptorRouter {
+    public:
+        // Поездка: ожидание автобуса bus на остановке board_stop и проезд span_count перегонов за ride_time минут
+        struct Leg {
+            std::string_view board_stop;
+            std::string_view bus;
+            uint32_t span_count;
+            double ride_time;
+        };
+
+        struct Journey {
+            double total_time;
+            std::vector<Leg> legs;
+        };
+
+        // Метка остановки в раунде. pattern == NO_PATTERN — время унаследовано от прошлого раунда или остановка
+        // не достигнута; иначе в этом раунде на остановку приехали рейсом pattern, сев на позиции board_position
+        struct Label {
+            double arrival;
+            uint32_t pattern;
+            uint32_t board_position;
+            uint32_t alight_position;
+        };
+
+        // Метки всех раундов поиска из остановки from; rounds[k][stop] — лучшее время не более чем за k поездок
+        struct Profile {
+            uint32_t from;
+            std::vector<std::vector<Label>> rounds;
+        };
+
+        static constexpr double UNREACHED = std::numeric_limits<double>::infinity();
+        static constexpr uint32_t NO_PATTERN = std::numeric_limits<uint32_t>::max();
+
+        RaptorRouter(const transport_catalogue::TransportCatalogue& db, double bus_velocity, double bus_wait_time);
+
+        // Номер в каталоге остановки, через которую проходит хотя бы один автобус
+        std::optional<uint32_t> FindStop(std::string_view stop_name) const;
+
+        // Поиск из from во все остановки. Если задана цель to, метки не лучше уже найденного времени до to
+        // отбрасываются: ответы для to и множество Парето для to остаются точными, для остальных остановок — нет.
+        // Метки позже max_arrival отбрасываются всегда
+        Profile Search(uint32_t from, std::optional<uint32_t> to = std::nullopt, double max_arrival = UNREACHED) const;
+
+        // Остановки, до которых можно доехать из from не дольше чем за max_time, и время прибытия на них
+        std::vector<std::pair<std::string_view, double>> FindStopsWithinTime(uint32_t from, double max_time) const;
+
+        // Самый быстрый маршрут до to
+        std::optional<Journey> GetJourney(const Profile& profile, uint32_t to) const;
+
+        // Множество Парето по времени и числу поездок: с каждой следующей поездкой маршрут строго быстрее
+        std::vector<Journey> GetParetoJourneys(const Profile& profile, uint32_t to) const;
+
+        // Ответ на запрос маршрута: перед каждой поездкой — ожидание автобуса
+        Route MakeRoute(const Journey& journey) const;
+
+        // Маршруты Парето между остановками from и to в порядке возрастания числа поездок.
+        // Пусто, если остановки неизвестны или маршрута нет
+        std::vector<Route> GetParetoRoutes(std::string_view from, std::string_view to) const;
+
+    private:
+        // Рейс — отрезок pattern_stops_ без разворота; некольцевой маршрут даёт два рейса, туда и обратно
+        struct Pattern {
+            uint32_t begin;
+            uint32_t end;
+            std::string_view bus;
+        };
+
+        // Рейс и позиция в нём, через которые проходит остановка
+        struct StopPosition {
+            uint32_t pattern;
+            uint32_t position;
+        };
+
+        const double bus_velocity_;
+        const double bus_wait_time_;
+
+        // Остановки нумеруются так же, как в каталоге
+        const transport_catalogue::TransportCatalogue& db_;
+
+        std::vector<Pattern> patterns_;
+        std::vector<uint32_t> pattern_stops_;
+        // Дорожное расстояние и время в пути от начала рейса до каждой позиции
+        std::vector<double> pattern_distances_;
+        std::vector<double> pattern_times_;
+
+        // Позиции остановки s занимают отрезок [stop_positions_offsets_[s], stop_positions_offsets_[s + 1])
+        std::vector<uint32_t> stop_positions_offsets_;
+        std::vector<StopPosition> stop_positions_;
+
+        void AddPattern(const transport_catalogue::TransportCatalogue& db, const transport_catalogue::Bus& bus,
+                        size_t begin, size_t end);
+
+        void BuildStopPositions();
+
+        double CalculateTravelTime(double distance) const;
+
+        Journey MakeJourney(const Profile& profile, size_t round, uint32_t to) const;
+    };
+}
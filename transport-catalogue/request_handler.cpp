@@ -9,7 +9,7 @@ std::optional<transport_catalogue::BusInfo> RequestHandler::GetBusStat(const std
     return db_.GetBusInfo(bus_name);
 }
 
-const std::unordered_set<RequestHandler::BusPtr>* RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
+const std::vector<RequestHandler::BusPtr>* RequestHandler::GetBusesByStop(const std::string_view& stop_name) const {
     return db_.GetStopInfo(stop_name);
 }
 
@@ -18,7 +18,7 @@ public:
     std::optional<transport_catalogue::BusInfo> GetBusStat(const std::string_view& bus_name) const;
 
     // Возвращает маршруты, проходящие через остановку
-    const std::unordered_set<BusPtr>* GetBusesByStop(const std::string_view& stop_name) const;
+    const std::vector<BusPtr>* GetBusesByStop(const std::string_view& stop_name) const;
     
     void RenderMap(std::ostream& out);
 
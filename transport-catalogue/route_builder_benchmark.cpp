@@ -0,0 +1,202 @@
+#include "city_generator.h"
+#include "domain.h"
+#include "thread_pool.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+// route_builder_benchmark — замер RouteBuilder на синтетических городах растущего размера: время построения,
+// прирост пиковой памяти процесса при построении, задержки GetRout (p50 и p99) для каждого движка,
+// а также задержка повторного прохода по тем же парам (p50) и попадания и промахи кеша маршрутов после обоих проходов.
+// Запуск: route_builder_benchmark [max_stop_count] [all_pairs_max_stop_count] [query_count]
+
+using namespace std::literals;
+
+namespace {
+
+    constexpr size_t MIN_STOP_COUNT = 250;
+    constexpr double BUS_VELOCITY = 40.;
+    constexpr double BUS_WAIT_TIME = 6.;
+
+    // Значение поля /proc/self/status в килобайтах; вне Linux — пусто
+    std::optional<size_t> ReadProcessStatusKb(std::string_view field) {
+        std::ifstream status("/proc/self/status"s);
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, field.size(), field) == 0 && line.size() > field.size() && line[field.size()] == ':') {
+                return std::stoul(line.substr(field.size() + 1));
+            }
+        }
+        return std::nullopt;
+    }
+
+    // Сбрасывает пик VmHWM до текущего размера, чтобы измерить пик одного построения
+    void ResetPeakMemory() {
+        std::ofstream clear_refs("/proc/self/clear_refs"s);
+        clear_refs << "5"sv;
+    }
+
+    struct Measurement {
+        double build_seconds;
+        std::optional<size_t> peak_memory_kb;
+        double p50_microseconds;
+        double p99_microseconds;
+        size_t found_count;
+        double cached_p50_microseconds;
+        cache::CacheStats cache_stats;
+    };
+
+    Measurement Measure(const transport_catalogue::TransportCatalogue& db, RouterType router_type,
+                        const std::vector<std::pair<std::string, std::string>>& queries) {
+        Measurement measurement{};
+
+        const auto memory_before = ReadProcessStatusKb("VmRSS"sv);
+        ResetPeakMemory();
+
+        const auto build_start = std::chrono::steady_clock::now();
+        const RouteBuilder route_builder(db, BUS_VELOCITY, BUS_WAIT_TIME, router_type, GraphModel::kPairwise,
+                                         WeightType::kMinutes, concurrency::GetDefaultThreadCount());
+        const std::chrono::duration<double> build_elapsed = std::chrono::steady_clock::now() - build_start;
+        measurement.build_seconds = build_elapsed.count();
+
+        if (const auto peak = ReadProcessStatusKb("VmHWM"sv); peak && memory_before) {
+            measurement.peak_memory_kb = *peak > *memory_before ? *peak - *memory_before : 0;
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve(queries.size());
+        for (const auto& [from, to] : queries) {
+            const auto start = std::chrono::steady_clock::now();
+            const auto route = route_builder.GetRout(from, to);
+            const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+
+            latencies.push_back(elapsed.count());
+            measurement.found_count += static_cast<size_t>(route != nullptr);
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+        if (!latencies.empty()) {
+            measurement.p50_microseconds = latencies[latencies.size() / 2];
+            measurement.p99_microseconds = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)];
+        }
+
+        // Повторный проход отвечает из кеша, если его ёмкость не меньше числа пар
+        latencies.clear();
+        for (const auto& [from, to] : queries) {
+            const auto start = std::chrono::steady_clock::now();
+            route_builder.GetRout(from, to);
+            const std::chrono::duration<double, std::micro> elapsed = std::chrono::steady_clock::now() - start;
+            latencies.push_back(elapsed.count());
+        }
+        std::sort(latencies.begin(), latencies.end());
+        if (!latencies.empty()) {
+            measurement.cached_p50_microseconds = latencies[latencies.size() / 2];
+        }
+        measurement.cache_stats = route_builder.GetRouteCacheStats();
+
+        return measurement;
+    }
+
+    // Случайные пары различных остановок, через которые проходят автобусы; пары не повторяются,
+    // поэтому кеш ответов RouteBuilder на замер не влияет
+    std::vector<std::pair<std::string, std::string>> MakeQueries(const synthetic::City& city, size_t query_count) {
+        std::unordered_set<size_t> served;
+        for (const auto& bus : city.buses) {
+            served.insert(bus.stops.begin(), bus.stops.end());
+        }
+        std::vector<size_t> stops(served.begin(), served.end());
+        std::sort(stops.begin(), stops.end());
+
+        std::vector<std::pair<std::string, std::string>> queries;
+        if (stops.size() < 2) {
+            return queries;
+        }
+
+        std::mt19937 generator(7);
+        std::uniform_int_distribution<size_t> stop_distribution(0, stops.size() - 1);
+        query_count = std::min(query_count, stops.size() * (stops.size() - 1));
+
+        std::unordered_set<uint64_t> used;
+        while (queries.size() < query_count) {
+            const size_t from = stops[stop_distribution(generator)];
+            const size_t to = stops[stop_distribution(generator)];
+            if (from != to && used.insert(static_cast<uint64_t>(from) << 32 | to).second) {
+                queries.emplace_back(city.stops[from].name, city.stops[to].name);
+            }
+        }
+
+        return queries;
+    }
+
+    std::string_view GetRouterName(RouterType router_type) {
+        switch (router_type) {
+            case RouterType::kAllPairs:
+                return "all_pairs"sv;
+            case RouterType::kDijkstra:
+                return "dijkstra"sv;
+            case RouterType::kAStar:
+                return "astar"sv;
+            case RouterType::kRaptor:
+                return "raptor"sv;
+        }
+        return ""sv;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t max_stop_count = argc > 1 ? std::stoul(argv[1]) : 4000;
+    const size_t all_pairs_max_stop_count = argc > 2 ? std::stoul(argv[2]) : 1000;
+    const size_t query_count = argc > 3 ? std::stoul(argv[3]) : 1000;
+
+    std::cout << std::setw(8) << "stops"sv << std::setw(8) << "buses"sv << std::setw(11) << "router"sv
+              << std::setw(11) << "build, s"sv << std::setw(13) << "memory, MB"sv
+              << std::setw(11) << "p50, us"sv << std::setw(11) << "p99, us"sv << std::setw(9) << "found"sv
+              << std::setw(13) << "cached p50"sv << std::setw(8) << "hits"sv << std::setw(8) << "misses"sv << '\n';
+
+    for (size_t stop_count = MIN_STOP_COUNT; stop_count <= max_stop_count; stop_count *= 2) {
+        synthetic::CityOptions options;
+        options.stop_count = stop_count;
+        options.bus_count = stop_count / 10;
+
+        const synthetic::City city = synthetic::GenerateCity(options);
+        transport_catalogue::TransportCatalogue db;
+        synthetic::FillCatalogue(city, db);
+        const auto queries = MakeQueries(city, query_count);
+
+        for (const RouterType router_type : {RouterType::kAllPairs, RouterType::kDijkstra, RouterType::kAStar,
+                                             RouterType::kRaptor}) {
+            // Таблица all_pairs квадратична по числу вершин, поэтому на больших городах не строится
+            if (router_type == RouterType::kAllPairs && stop_count > all_pairs_max_stop_count) {
+                continue;
+            }
+
+            const Measurement measurement = Measure(db, router_type, queries);
+
+            std::cout << std::setw(8) << stop_count << std::setw(8) << city.buses.size()
+                      << std::setw(11) << GetRouterName(router_type)
+                      << std::setw(11) << std::fixed << std::setprecision(3) << measurement.build_seconds;
+            if (measurement.peak_memory_kb) {
+                std::cout << std::setw(13) << std::setprecision(1) << *measurement.peak_memory_kb / 1024.;
+            } else {
+                std::cout << std::setw(13) << "-"sv;
+            }
+            std::cout << std::setw(11) << std::setprecision(1) << measurement.p50_microseconds
+                      << std::setw(11) << measurement.p99_microseconds
+                      << std::setw(9) << measurement.found_count
+                      << std::setw(13) << measurement.cached_p50_microseconds
+                      << std::setw(8) << measurement.cache_stats.hits
+                      << std::setw(8) << measurement.cache_stats.misses << '\n';
+        }
+    }
+}
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "graph.h"
+#include "radix_heap.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <unordered_map>
@@ -14,104 +17,313 @@
 
 namespace graph {
 
+// Общий интерфейс движков маршрутизации: RouteBuilder выбирает реализацию по настройкам
 template <typename Weight>
-class Router {
-private:
-    using Graph = DirectedWeightedGraph<Weight>;
-
+class RouterBase {
 public:
-    explicit Router(const Graph& graph);
-
     struct RouteInfo {
         Weight weight;
         std::vector<EdgeId> edges;
     };
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    // Кратчайшие пути из одной вершины во все остальные. Движок с готовой таблицей хранит только from,
+    // движок поиска заполняет вес и последнее ребро пути для каждой вершины
+    struct RoutesTree {
+        VertexId from;
+        std::vector<std::optional<Weight>> weights;
+        std::vector<std::optional<EdgeId>> prev_edges;
+    };
 
-private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    virtual ~RouterBase() = default;
+
+    virtual std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Дерево строится один раз и переиспользуется для маршрутов ко всем вершинам
+    virtual RoutesTree BuildRoutesTree(VertexId from) const = 0;
+    virtual std::optional<RouteInfo> BuildRoute(const RoutesTree& tree, VertexId to) const = 0;
+};
+
+// Graph — DirectedWeightedGraph или FrozenGraph: нужны GetVertexCount, GetEdge и GetIncidentEdges
+template <typename Weight, typename Graph = DirectedWeightedGraph<Weight>>
+class Router : public RouterBase<Weight> {
+public:
+    using RouteInfo = typename RouterBase<Weight>::RouteInfo;
+    using RoutesTree = typename RouterBase<Weight>::RoutesTree;
+
+    // Таблица маршрутов — две плоские матрицы V×V, строка за строкой: веса кратчайших путей и последние рёбра этих путей.
+    // Отсутствие маршрута обозначается весом INFINITE_WEIGHT, отсутствие последнего ребра — NO_EDGE
+    struct RoutesInternalData {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
 
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                              ? std::numeric_limits<Weight>::infinity()
+                                              : std::numeric_limits<Weight>::max() / 2;
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    // При thread_count > 1 строки таблицы для каждой промежуточной вершины релаксируются блоками на пуле потоков.
+    // Результат не зависит от числа потоков
+    explicit Router(const Graph& graph, size_t thread_count = 1);
+    // Восстанавливает маршрутизатор из ранее рассчитанной таблицы, без повторных вычислений
+    Router(const Graph& graph, RoutesInternalData routes_internal_data);
+    // Переносит таблицу, рассчитанную для прежнего графа с теми же вершинами, на graph.
+    // new_edge_ids[id] — номер прежнего ребра id в graph или NO_EDGE, если ребро удалено; added_edges — новые рёбра graph.
+    // Строки, в дереве путей которых было удалённое ребро, пересчитываются поиском Дейкстры,
+    // затем каждое новое ребро улучшает все пары за O(V²)
+    Router(const Graph& graph, RoutesInternalData previous_data, const std::vector<uint32_t>& new_edge_ids,
+           const std::vector<EdgeId>& added_edges, size_t thread_count = 1);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // Дерево путей из from — это строка таблицы, поэтому дерево хранит только from
+    RoutesTree BuildRoutesTree(VertexId from) const override;
+    std::optional<RouteInfo> BuildRoute(const RoutesTree& tree, VertexId to) const override;
+
+    const RoutesInternalData& GetRoutesInternalData() const {
+        return routes_internal_data_;
+    }
+
+private:
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for 32-bit edge ids");
+        }
+
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
+            Weight* const row_weights = &routes_internal_data_.weights[vertex * vertex_count];
+            uint32_t* const row_prev_edges = &routes_internal_data_.prev_edges[vertex * vertex_count];
+
+            row_weights[vertex] = ZERO_WEIGHT;
             for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
                 const auto& edge = graph.GetEdge(edge_id);
                 if (edge.weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                if (row_weights[edge.to] > edge.weight) {
+                    row_weights[edge.to] = edge.weight;
+                    row_prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
                 }
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    // Строки с разными vertex_from независимы: каждая читает только себя и строку vertex_through,
+    // а строка vertex_through через саму себя не улучшается и поэтому пропускается.
+    // Внутренний цикл без ветвлений (min-plus по строке), поэтому компилятор может его векторизовать
+    void RelaxRoutesInternalDataThroughVertex(VertexId from_begin, VertexId from_end, size_t vertex_count,
+                                              VertexId vertex_through) {
+        const Weight* const through_weights = &routes_internal_data_.weights[vertex_through * vertex_count];
+        const uint32_t* const through_prev_edges = &routes_internal_data_.prev_edges[vertex_through * vertex_count];
+
+        for (VertexId vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+            Weight* const row_weights = &routes_internal_data_.weights[vertex_from * vertex_count];
+            uint32_t* const row_prev_edges = &routes_internal_data_.prev_edges[vertex_from * vertex_count];
+
+            const Weight weight_from = row_weights[vertex_through];
+            if (vertex_from == vertex_through || weight_from == INFINITE_WEIGHT) {
+                continue;
+            }
+            const uint32_t prev_edge_from = row_prev_edges[vertex_through];
+
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                const Weight candidate_weight = weight_from + through_weights[vertex_to];
+                const uint32_t candidate_prev_edge = through_prev_edges[vertex_to] != NO_EDGE
+                                                     ? through_prev_edges[vertex_to]
+                                                     : prev_edge_from;
+                const bool is_better = candidate_weight < row_weights[vertex_to];
+                row_weights[vertex_to] = is_better ? candidate_weight : row_weights[vertex_to];
+                row_prev_edges[vertex_to] = is_better ? candidate_prev_edge : row_prev_edges[vertex_to];
+            }
         }
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
-                    }
+    // Путь from → edge.from, ребро edge и путь edge.to → vertex_to. Строку edge.to читают все потоки,
+    // поэтому она пропускается: путь из edge.to через само ребро — цикл, и он не короче уже известного
+    void RelaxRoutesInternalDataThroughEdge(VertexId from_begin, VertexId from_end, size_t vertex_count, EdgeId edge_id) {
+        const auto& edge = graph_.GetEdge(edge_id);
+        const Weight* const through_weights = &routes_internal_data_.weights[edge.to * vertex_count];
+        const uint32_t* const through_prev_edges = &routes_internal_data_.prev_edges[edge.to * vertex_count];
+
+        for (VertexId vertex_from = from_begin; vertex_from < from_end; ++vertex_from) {
+            Weight* const row_weights = &routes_internal_data_.weights[vertex_from * vertex_count];
+            uint32_t* const row_prev_edges = &routes_internal_data_.prev_edges[vertex_from * vertex_count];
+
+            if (vertex_from == edge.to || row_weights[edge.from] == INFINITE_WEIGHT) {
+                continue;
+            }
+            const Weight weight_from = row_weights[edge.from] + edge.weight;
+
+            for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+                const Weight candidate_weight = weight_from + through_weights[vertex_to];
+                if (candidate_weight < row_weights[vertex_to]) {
+                    row_weights[vertex_to] = candidate_weight;
+                    row_prev_edges[vertex_to] = through_prev_edges[vertex_to] != NO_EDGE
+                                                ? through_prev_edges[vertex_to]
+                                                : static_cast<uint32_t>(edge_id);
+                }
+            }
+        }
+    }
+
+    // Заново считает строку таблицы поиском Дейкстры по текущему графу
+    void RecomputeRoutesInternalDataRow(VertexId vertex_from, size_t vertex_count) {
+        Weight* const row_weights = &routes_internal_data_.weights[vertex_from * vertex_count];
+        uint32_t* const row_prev_edges = &routes_internal_data_.prev_edges[vertex_from * vertex_count];
+        std::fill(row_weights, row_weights + vertex_count, INFINITE_WEIGHT);
+        std::fill(row_prev_edges, row_prev_edges + vertex_count, NO_EDGE);
+
+        SearchQueue<Weight, VertexId> queue;
+
+        row_weights[vertex_from] = ZERO_WEIGHT;
+        queue.Push(ZERO_WEIGHT, vertex_from);
+
+        while (!queue.IsEmpty()) {
+            const auto [weight, vertex] = queue.Pop();
+            if (row_weights[vertex] < weight) {
+                continue;
+            }
+
+            for (const EdgeId edge_id : graph_.GetIncidentEdges(vertex)) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                const Weight candidate_weight = weight + edge.weight;
+                if (candidate_weight < row_weights[edge.to]) {
+                    row_weights[edge.to] = candidate_weight;
+                    row_prev_edges[edge.to] = static_cast<uint32_t>(edge_id);
+                    queue.Push(candidate_weight, edge.to);
                 }
             }
         }
     }
 
     static constexpr Weight ZERO_WEIGHT{};
+    static constexpr size_t MIN_ROWS_PER_BLOCK = 16;
     const Graph& graph_;
     RoutesInternalData routes_internal_data_;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, size_t thread_count)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , routes_internal_data_{std::vector<Weight>(graph.GetVertexCount() * graph.GetVertexCount(), INFINITE_WEIGHT),
+                            std::vector<uint32_t>(graph.GetVertexCount() * graph.GetVertexCount(), NO_EDGE)}
 {
     InitializeRoutesInternalData(graph);
 
     const size_t vertex_count = graph.GetVertexCount();
+    if (thread_count <= 1) {
+        for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
+            RelaxRoutesInternalDataThroughVertex(0, vertex_count, vertex_count, vertex_through);
+        }
+        return;
+    }
+
+    concurrency::ThreadPool pool(thread_count);
+    const size_t rows_per_block = std::max(MIN_ROWS_PER_BLOCK, vertex_count / (thread_count * 8));
     for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+        pool.ParallelFor(0, vertex_count, rows_per_block, [this, vertex_count, vertex_through](size_t begin, size_t end) {
+            RelaxRoutesInternalDataThroughVertex(begin, end, vertex_count, vertex_through);
+        });
     }
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    const size_t cells_count = graph.GetVertexCount() * graph.GetVertexCount();
+    if (routes_internal_data_.weights.size() != cells_count || routes_internal_data_.prev_edges.size() != cells_count) {
+        throw std::invalid_argument("Routes internal data does not match the graph");
+    }
+}
+
+template <typename Weight, typename Graph>
+Router<Weight, Graph>::Router(const Graph& graph, RoutesInternalData previous_data, const std::vector<uint32_t>& new_edge_ids,
+                              const std::vector<EdgeId>& added_edges, size_t thread_count)
+    : Router(graph, std::move(previous_data))
+{
+    const size_t vertex_count = graph.GetVertexCount();
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for 32-bit edge ids");
+    }
+    for (const EdgeId edge_id : added_edges) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+
+    // Перенумерация рёбер; строка, потерявшая ребро своего дерева путей, считается заново
+    std::vector<VertexId> affected_rows;
+    for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
+        uint32_t* const row_prev_edges = &routes_internal_data_.prev_edges[vertex_from * vertex_count];
+        bool is_affected = false;
+        for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
+            if (row_prev_edges[vertex_to] != NO_EDGE) {
+                row_prev_edges[vertex_to] = new_edge_ids.at(row_prev_edges[vertex_to]);
+                is_affected = is_affected || row_prev_edges[vertex_to] == NO_EDGE;
+            }
+        }
+        if (is_affected) {
+            affected_rows.push_back(vertex_from);
+        }
+    }
+
+    concurrency::ThreadPool pool(thread_count);
+    pool.ParallelFor(0, affected_rows.size(), 1, [this, &affected_rows, vertex_count](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            RecomputeRoutesInternalDataRow(affected_rows[i], vertex_count);
+        }
+    });
+
+    // Остальные строки кратчайшие для графа без новых рёбер; пересчитанные уже учитывают новые рёбра
+    const size_t rows_per_block = std::max(MIN_ROWS_PER_BLOCK, vertex_count / (pool.GetThreadCount() * 8));
+    for (const EdgeId edge_id : added_edges) {
+        pool.ParallelFor(0, vertex_count, rows_per_block, [this, vertex_count, edge_id](size_t begin, size_t end) {
+            RelaxRoutesInternalDataThroughEdge(begin, end, vertex_count, edge_id);
+        });
+    }
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo> Router<Weight, Graph>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    const size_t row_begin = from * vertex_count;
+    const Weight weight = routes_internal_data_.weights[row_begin + to];
+    if (weight == INFINITE_WEIGHT) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (uint32_t edge_id = routes_internal_data_.prev_edges[row_begin + to];
+         edge_id != NO_EDGE;
+         edge_id = routes_internal_data_.prev_edges[row_begin + graph_.GetEdge(edge_id).from])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
+template <typename Weight, typename Graph>
+typename Router<Weight, Graph>::RoutesTree Router<Weight, Graph>::BuildRoutesTree(VertexId from) const {
+    if (from >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    return RoutesTree{from, {}, {}};
+}
+
+template <typename Weight, typename Graph>
+std::optional<typename Router<Weight, Graph>::RouteInfo> Router<Weight, Graph>::BuildRoute(const RoutesTree& tree,
+                                                                                           VertexId to) const {
+    return BuildRoute(tree.from, to);
+}
+
 }  // namespace graph
@@ -0,0 +1,118 @@
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// router_benchmark — замер времени предварительного расчёта graph::Router на случайном графе
+// при числе потоков от 1 до N и времени поиска Дейкстры с весами double (двоичная куча)
+// и целыми весами (RadixHeap). Запуск: router_benchmark [vertex_count] [max_threads]
+
+using namespace std::literals;
+
+namespace {
+
+    graph::DirectedWeightedGraph<double> MakeRandomGraph(size_t vertex_count, size_t edges_per_vertex) {
+        std::mt19937 generator(42);
+        std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+        std::uniform_real_distribution<double> weight_distribution(1., 100.);
+
+        graph::DirectedWeightedGraph<double> graph(vertex_count);
+        for (graph::VertexId from = 0; from < vertex_count; ++from) {
+            for (size_t i = 0; i < edges_per_vertex; ++i) {
+                graph.AddEdge({from, vertex_distribution(generator), weight_distribution(generator), "edge"sv, 1});
+            }
+        }
+
+        return graph;
+    }
+
+    // Те же рёбра с весами в сотых долях исходной единицы
+    graph::DirectedWeightedGraph<uint32_t> MakeFixedPointGraph(const graph::DirectedWeightedGraph<double>& graph) {
+        graph::DirectedWeightedGraph<uint32_t> fixed_graph(graph.GetVertexCount());
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            fixed_graph.AddEdge({edge.from, edge.to, static_cast<uint32_t>(std::lround(edge.weight * 100.)),
+                                 edge.name, edge.span_count});
+        }
+
+        return fixed_graph;
+    }
+
+    // Время построения деревьев путей из всех вершин
+    template <typename Weight>
+    double MeasureSearches(const graph::DirectedWeightedGraph<Weight>& graph) {
+        const graph::DijkstraRouter<Weight> router(graph);
+
+        const auto start = std::chrono::steady_clock::now();
+        size_t reached = 0;
+        for (graph::VertexId from = 0; from < graph.GetVertexCount(); ++from) {
+            const auto tree = router.BuildRoutesTree(from);
+            reached += static_cast<size_t>(tree.weights.back().has_value());
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        // Результат используется, чтобы компилятор не выбросил поиск
+        if (reached > graph.GetVertexCount()) {
+            std::cerr << "unreachable"sv;
+        }
+        return elapsed.count();
+    }
+
+    bool IsSameTable(const graph::Router<double>& lhs, const graph::Router<double>& rhs) {
+        const auto& lhs_data = lhs.GetRoutesInternalData();
+        const auto& rhs_data = rhs.GetRoutesInternalData();
+
+        return lhs_data.weights == rhs_data.weights && lhs_data.prev_edges == rhs_data.prev_edges;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 1000;
+    const size_t max_threads = argc > 2 ? std::stoul(argv[2]) : concurrency::GetDefaultThreadCount();
+
+    const auto graph = MakeRandomGraph(vertex_count, 8);
+    std::cout << "vertices: "sv << graph.GetVertexCount() << ", edges: "sv << graph.GetEdgeCount() << '\n';
+    std::cout << std::setw(8) << "threads"sv << std::setw(12) << "seconds"sv << std::setw(10) << "speedup"sv << '\n';
+
+    std::unique_ptr<graph::Router<double>> reference;
+    double reference_seconds = 0.;
+
+    for (size_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        const auto start = std::chrono::steady_clock::now();
+        auto router = std::make_unique<graph::Router<double>>(graph, thread_count);
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if (!reference) {
+            reference = std::move(router);
+            reference_seconds = elapsed.count();
+        } else if (!IsSameTable(*reference, *router)) {
+            std::cerr << "Routes table differs for "sv << thread_count << " threads\n"sv;
+            return 1;
+        }
+
+        std::cout << std::setw(8) << thread_count
+                  << std::setw(12) << std::fixed << std::setprecision(3) << elapsed.count()
+                  << std::setw(10) << std::setprecision(2) << reference_seconds / elapsed.count() << '\n';
+
+        if (thread_count < max_threads && thread_count * 2 > max_threads) {
+            thread_count = max_threads / 2;
+        }
+    }
+
+    const double double_seconds = MeasureSearches(graph);
+    const double fixed_seconds = MeasureSearches(MakeFixedPointGraph(graph));
+    std::cout << "dijkstra from every vertex: double "sv << std::setprecision(3) << double_seconds
+              << " s, fixed-point "sv << fixed_seconds << " s, speedup "sv
+              << std::setprecision(2) << double_seconds / fixed_seconds << '\n';
+}
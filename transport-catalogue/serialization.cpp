@@ -1,5 +1,7 @@
 #include "serialization.h"
 
+#include <stdexcept>
+
 transport_catalogue_serialize::Color GetColor(svg::Color& col) {
     transport_catalogue_serialize::Color ser_col;
     if (std::holds_alternative<std::string>(col)) {
@@ -92,9 +94,44 @@ transport_catalogue_serialize::TransportCatalogue SerializeTransportCatalogue(se
     return tc;
 }
 
-void Serialize(const std::filesystem::path& path, serialization_data::SerializationData&& s_data) {
-    std::ofstream out_file(path, std::ios::binary);
+transport_catalogue_serialize::RouterType SerializeRouterType(RouterType router_type) {
+    switch (router_type) {
+        case RouterType::kDijkstra:
+            return transport_catalogue_serialize::DIJKSTRA;
+        case RouterType::kAStar:
+            return transport_catalogue_serialize::ASTAR;
+        case RouterType::kRaptor:
+            return transport_catalogue_serialize::RAPTOR;
+        default:
+            return transport_catalogue_serialize::ALL_PAIRS;
+    }
+}
+
+transport_catalogue_serialize::RouterData SerializeRouterData(serialization_data::RouterData& rd_data) {
+    transport_catalogue_serialize::RouterData rd;
+
+    rd.mutable_names()->Add(rd_data.names.begin(), rd_data.names.end());
+    rd.mutable_stop_vertices()->Add(rd_data.stop_vertices.begin(), rd_data.stop_vertices.end());
+
+    for (const auto& [from, to, weight, name, span_count] : rd_data.edges) {
+        transport_catalogue_serialize::GraphEdge* edge = rd.add_edges();
+        edge->set_from(from);
+        edge->set_to(to);
+        edge->set_weight(weight);
+        edge->set_name(name);
+        edge->set_span_count(span_count);
+    }
+
+    rd.mutable_offsets()->Add(rd_data.offsets.begin(), rd_data.offsets.end());
 
+    rd.mutable_route_weights()->Add(rd_data.route_weights.begin(), rd_data.route_weights.end());
+    rd.mutable_route_prev_edges()->Add(rd_data.route_prev_edges.begin(), rd_data.route_prev_edges.end());
+    rd.mutable_ride_distances()->Add(rd_data.ride_distances.begin(), rd_data.ride_distances.end());
+
+    return rd;
+}
+
+void Serialize(const std::filesystem::path& path, serialization_data::SerializationData&& s_data) {
     transport_catalogue_serialize::SerializationSetting ss;
 
     *ss.mutable_transport_catalogue() = std::move(SerializeTransportCatalogue(s_data));
@@ -105,10 +142,30 @@ void Serialize(const std::filesystem::path& path, serialization_data::Serializat
 
     rs.set_bus_wait_time(s_data.route_settings.bus_wait_time);
     rs.set_bus_velocity(s_data.route_settings.bus_velocity);
+    rs.set_router_type(SerializeRouterType(s_data.route_settings.router_type));
+    rs.set_route_cache_size(s_data.route_settings.route_cache_size);
+    rs.set_graph_model(s_data.route_settings.graph_model == GraphModel::kLinear
+                       ? transport_catalogue_serialize::LINEAR
+                       : transport_catalogue_serialize::PAIRWISE);
+    rs.set_weight_type(s_data.route_settings.weight_type == WeightType::kFixedPoint
+                       ? transport_catalogue_serialize::FIXED_POINT
+                       : transport_catalogue_serialize::MINUTES);
 
     *ss.mutable_rs() = std::move(rs);
 
-    ss.SerializeToOstream(&out_file);
+    *ss.mutable_router_data() = std::move(SerializeRouterData(s_data.router_data));
+
+    // База пишется во временный файл и подменяет старую переименованием, поэтому работающий process_requests
+    // никогда не читает наполовину записанную базу
+    std::filesystem::path tmp_path = path;
+    tmp_path += ".tmp";
+    {
+        std::ofstream out_file(tmp_path, std::ios::binary);
+        if (!ss.SerializeToOstream(&out_file) || !out_file.flush()) {
+            throw std::runtime_error("Failed to write base " + tmp_path.string());
+        }
+    }
+    std::filesystem::rename(tmp_path, path);
 }
 
 svg::Color DeserializeGetColor(transport_catalogue_serialize::Color& c) {
@@ -207,13 +264,46 @@ renderer::VisualizationSettings DeserializeVisualizationSettings(transport_catal
     return des_vs;
 }
 
+RouterType DeserializeRouterType(transport_catalogue_serialize::RouterType router_type) {
+    switch (router_type) {
+        case transport_catalogue_serialize::DIJKSTRA:
+            return RouterType::kDijkstra;
+        case transport_catalogue_serialize::ASTAR:
+            return RouterType::kAStar;
+        case transport_catalogue_serialize::RAPTOR:
+            return RouterType::kRaptor;
+        default:
+            return RouterType::kAllPairs;
+    }
+}
+
+serialization_data::RouterData DeserializeRouterData(transport_catalogue_serialize::RouterData& rd) {
+    serialization_data::RouterData rd_data;
+
+    rd_data.names.assign(rd.names().begin(), rd.names().end());
+    rd_data.stop_vertices.assign(rd.stop_vertices().begin(), rd.stop_vertices().end());
+
+    rd_data.edges.reserve(rd.edges_size());
+    for (const auto& edge : rd.edges()) {
+        rd_data.edges.push_back({edge.from(), edge.to(), edge.weight(), edge.name(), edge.span_count()});
+    }
+
+    rd_data.offsets.assign(rd.offsets().begin(), rd.offsets().end());
+
+    rd_data.route_weights.assign(rd.route_weights().begin(), rd.route_weights().end());
+    rd_data.route_prev_edges.assign(rd.route_prev_edges().begin(), rd.route_prev_edges().end());
+    rd_data.ride_distances.assign(rd.ride_distances().begin(), rd.ride_distances().end());
+
+    return rd_data;
+}
+
 serialization_data::SerializationData Deserialize(const std::filesystem::path& path) {
     std::ifstream in_file(path, std::ios::binary);
 
     transport_catalogue_serialize::SerializationSetting ss;
 
-    if (!ss.ParseFromIstream(&in_file)) {
-        throw;
+    if (!in_file || !ss.ParseFromIstream(&in_file)) {
+        throw std::runtime_error("Failed to read base " + path.string());
     }
 
     serialization_data::SerializationData s_data = DeserializeTransportCatalogue(*ss.mutable_transport_catalogue());
@@ -224,6 +314,16 @@ serialization_data::SerializationData Deserialize(const std::filesystem::path& p
 
     s_data.route_settings.bus_velocity = rs.bus_velocity();
     s_data.route_settings.bus_wait_time = rs.bus_wait_time();
+    s_data.route_settings.router_type = DeserializeRouterType(rs.router_type());
+    s_data.route_settings.route_cache_size = rs.route_cache_size();
+    s_data.route_settings.graph_model = rs.graph_model() == transport_catalogue_serialize::LINEAR
+                                        ? GraphModel::kLinear
+                                        : GraphModel::kPairwise;
+    s_data.route_settings.weight_type = rs.weight_type() == transport_catalogue_serialize::FIXED_POINT
+                                        ? WeightType::kFixedPoint
+                                        : WeightType::kMinutes;
+
+    s_data.router_data = DeserializeRouterData(*ss.mutable_router_data());
 
     return std::move(s_data);
 }
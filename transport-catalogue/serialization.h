@@ -15,9 +15,13 @@ void Serialize(const std::filesystem::path& path, serialization_data::Serializat
 transport_catalogue_serialize::TransportCatalogue SerializeTransportCatalogue(serialization_data::SerializationData& s_data);
 transport_catalogue_serialize::VisualizationSettings SerializeVisualizationSettings(renderer::VisualizationSettings& vs_data);
 transport_catalogue_serialize::Color GetColor(svg::Color& col);
+transport_catalogue_serialize::RouterType SerializeRouterType(RouterType router_type);
+transport_catalogue_serialize::RouterData SerializeRouterData(serialization_data::RouterData& rd_data);
 
 serialization_data::SerializationData Deserialize(const std::filesystem::path& path);
 
 renderer::VisualizationSettings DeserializeVisualizationSettings(transport_catalogue_serialize::VisualizationSettings vs);
 serialization_data::SerializationData DeserializeTransportCatalogue(transport_catalogue_serialize::TransportCatalogue& tc);
 svg::Color DeserializeGetColor(transport_catalogue_serialize::Color& c);
+RouterType DeserializeRouterType(transport_catalogue_serialize::RouterType router_type);
+serialization_data::RouterData DeserializeRouterData(transport_catalogue_serialize::RouterData& rd);
@@ -0,0 +1,206 @@
+#define _USE_MATH_DEFINES
+
+#include "stop_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+namespace transport_catalogue {
+
+    namespace {
+
+        constexpr double DEGREE = M_PI / 180.;
+        // В среднем столько остановок приходится на ячейку сетки
+        constexpr size_t STOPS_PER_CELL = 2;
+        // Ограничение снизу на косинус широты, чтобы у полюсов ячейки не вырождались
+        constexpr double MIN_LATITUDE_COS = 0.01;
+
+        // Наименьшая разность долгот в градусах между lng и отрезком долгот [from, to] с учётом перехода через 180°
+        double GetLongitudeGap(double lng, double from, double to) {
+            if (from <= lng && lng <= to) {
+                return 0.;
+            }
+            const auto wrap = [](double delta) {
+                delta = std::fmod(std::abs(delta), 360.);
+                return std::min(delta, 360. - delta);
+            };
+            return std::min(wrap(lng - from), wrap(lng - to));
+        }
+
+        bool IsCloser(const NearbyStop& lhs, const NearbyStop& rhs) {
+            return std::tie(lhs.distance, lhs.stop->stop_name) < std::tie(rhs.distance, rhs.stop->stop_name);
+        }
+    }
+
+    StopIndex::StopIndex(const std::deque<Stop>& stops) {
+        if (stops.empty()) {
+            return;
+        }
+
+        double max_lat = stops.front().coordinates.lat;
+        min_lat_ = max_lat;
+        min_lng_ = max_lng_ = stops.front().coordinates.lng;
+        for (const Stop& stop : stops) {
+            min_lat_ = std::min(min_lat_, stop.coordinates.lat);
+            max_lat = std::max(max_lat, stop.coordinates.lat);
+            min_lng_ = std::min(min_lng_, stop.coordinates.lng);
+            max_lng_ = std::max(max_lng_, stop.coordinates.lng);
+        }
+
+        // Размеры области в градусах широты: градус долготы короче в cos(широты) раз
+        const double latitude_cos = std::max(MIN_LATITUDE_COS, std::cos((min_lat_ + max_lat) / 2. * DEGREE));
+        const double height = max_lat - min_lat_;
+        const double width = (max_lng_ - min_lng_) * latitude_cos;
+
+        const size_t target_cells = std::max<size_t>(1, stops.size() / STOPS_PER_CELL);
+        double side = std::sqrt(height * width / target_cells);
+        if (side == 0.) {
+            // Все остановки на одной линии широты или долготы
+            side = std::max(height, width) / target_cells;
+        }
+
+        rows_ = columns_ = 1;
+        if (side > 0.) {
+            lat_step_ = side;
+            lng_step_ = side / latitude_cos;
+            rows_ = std::min(target_cells, static_cast<size_t>(height / side) + 1);
+            columns_ = std::min(target_cells, static_cast<size_t>(width / side) + 1);
+        }
+
+        // Раскладка по ячейкам подсчётом: сначала размеры ячеек, затем остановки на свои места
+        std::vector<size_t> stop_cells;
+        stop_cells.reserve(stops.size());
+        cell_offsets_.assign(rows_ * columns_ + 1, 0);
+        for (const Stop& stop : stops) {
+            stop_cells.push_back(GetRow(stop.coordinates.lat) * columns_ + GetColumn(stop.coordinates.lng));
+            ++cell_offsets_[stop_cells.back() + 1];
+        }
+        for (size_t cell = 1; cell < cell_offsets_.size(); ++cell) {
+            cell_offsets_[cell] += cell_offsets_[cell - 1];
+        }
+
+        cell_stops_.resize(stops.size());
+        cell_coordinates_.resize(stops.size());
+        std::vector<uint32_t> positions(cell_offsets_.begin(), cell_offsets_.end() - 1);
+        for (const Stop& stop : stops) {
+            const uint32_t position = positions[stop_cells[stop.id]]++;
+            cell_stops_[position] = &stop;
+            cell_coordinates_[position] = stop.coordinates;
+        }
+    }
+
+    size_t StopIndex::GetRow(double lat) const {
+        if (!(lat > min_lat_)) {
+            return 0;
+        }
+        return std::min(rows_ - 1, static_cast<size_t>(std::min((lat - min_lat_) / lat_step_, double(rows_))));
+    }
+
+    size_t StopIndex::GetColumn(double lng) const {
+        if (!(lng > min_lng_)) {
+            return 0;
+        }
+        return std::min(columns_ - 1, static_cast<size_t>(std::min((lng - min_lng_) / lng_step_, double(columns_))));
+    }
+
+    double StopIndex::GetOutsideDistanceBound(geo::Coordinates point, size_t first_row, size_t last_row,
+                                              size_t first_column, size_t last_column) const {
+        double bound = std::numeric_limits<double>::infinity();
+
+        // За пределами строк прямоугольника остановки отстоят по широте не меньше чем на расстояние до его края,
+        // а дуга меридиана — кратчайший путь между широтами
+        if (first_row > 0) {
+            const double edge = min_lat_ + first_row * lat_step_;
+            bound = std::min(bound, std::max(0., point.lat - edge) * DEGREE * geo::kGroundRadius);
+        }
+        if (last_row + 1 < rows_) {
+            const double edge = min_lat_ + (last_row + 1) * lat_step_;
+            bound = std::min(bound, std::max(0., edge - point.lat) * DEGREE * geo::kGroundRadius);
+        }
+
+        // За пределами столбцов — не ближе меридиана края прямоугольника: расстояние d до меридиана,
+        // отстоящего на разность долгот g, задаёт sin(d) = cos(широта) · sin(g)
+        const auto meridian_bound = [&point](double gap) {
+            const double sin_distance = std::cos(point.lat * DEGREE) * std::sin(std::min(gap, 90.) * DEGREE);
+            return std::asin(std::clamp(sin_distance, 0., 1.)) * geo::kGroundRadius;
+        };
+        if (first_column > 0) {
+            const double edge = min_lng_ + first_column * lng_step_;
+            bound = std::min(bound, meridian_bound(GetLongitudeGap(point.lng, min_lng_, edge)));
+        }
+        if (last_column + 1 < columns_) {
+            const double edge = min_lng_ + (last_column + 1) * lng_step_;
+            bound = std::min(bound, meridian_bound(GetLongitudeGap(point.lng, edge, max_lng_)));
+        }
+
+        return bound;
+    }
+
+    std::vector<NearbyStop> StopIndex::FindNearest(geo::Coordinates point, size_t max_count,
+                                                   double max_distance) const {
+        std::vector<NearbyStop> found;
+        if (rows_ == 0 || max_count == 0 || !(max_distance >= 0.)) {
+            return found;
+        }
+
+        // found — куча с самой дальней из найденных остановок на вершине; как только найдено max_count остановок,
+        // дальше неё искать незачем
+        double threshold = max_distance;
+        const auto visit_cell = [&](size_t row, size_t column) {
+            const size_t cell = row * columns_ + column;
+            for (uint32_t i = cell_offsets_[cell]; i < cell_offsets_[cell + 1]; ++i) {
+                const NearbyStop candidate{cell_stops_[i], geo::ComputeDistance(point, cell_coordinates_[i])};
+                if (candidate.distance > threshold
+                    || (found.size() == max_count && !IsCloser(candidate, found.front()))) {
+                    continue;
+                }
+
+                found.push_back(candidate);
+                std::push_heap(found.begin(), found.end(), IsCloser);
+                if (found.size() > max_count) {
+                    std::pop_heap(found.begin(), found.end(), IsCloser);
+                    found.pop_back();
+                }
+                if (found.size() == max_count) {
+                    threshold = std::min(max_distance, found.front().distance);
+                }
+            }
+        };
+
+        // Кольцо radius — ячейки на расстоянии ровно radius ячеек от ячейки точки по строке или столбцу
+        const size_t point_row = GetRow(point.lat);
+        const size_t point_column = GetColumn(point.lng);
+        for (size_t radius = 0;; ++radius) {
+            const size_t first_row = point_row >= radius ? point_row - radius : 0;
+            const size_t last_row = std::min(rows_ - 1, point_row + radius);
+            const size_t first_column = point_column >= radius ? point_column - radius : 0;
+            const size_t last_column = std::min(columns_ - 1, point_column + radius);
+
+            for (size_t row = first_row; row <= last_row; ++row) {
+                if (row + radius == point_row || row == point_row + radius) {
+                    for (size_t column = first_column; column <= last_column; ++column) {
+                        visit_cell(row, column);
+                    }
+                    continue;
+                }
+                if (point_column >= radius) {
+                    visit_cell(row, point_column - radius);
+                }
+                if (point_column + radius < columns_) {
+                    visit_cell(row, point_column + radius);
+                }
+            }
+
+            const bool covers_grid = first_row == 0 && last_row + 1 == rows_
+                                     && first_column == 0 && last_column + 1 == columns_;
+            if (covers_grid
+                || GetOutsideDistanceBound(point, first_row, last_row, first_column, last_column) > threshold) {
+                break;
+            }
+        }
+
+        std::sort_heap(found.begin(), found.end(), IsCloser);
+        return found;
+    }
+}
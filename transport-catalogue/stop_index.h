@@ -0,0 +1,60 @@
+#pragma once
+
+#include "domain.h"
+#include "geo.h"
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <vector>
+
+// stop_index — пространственный индекс остановок: равномерная сетка по широте и долготе, ячейки которой
+// близки к квадратам на местности. Поиск обходит ячейки кольцами вокруг точки и останавливается, когда
+// нижняя оценка расстояния до ещё не просмотренных ячеек превышает найденные расстояния
+
+namespace transport_catalogue {
+
+    struct NearbyStop {
+        const Stop* stop;
+        // Расстояние от точки запроса по поверхности Земли, в метрах
+        double distance;
+    };
+
+    class StopIndex {
+    public:
+        StopIndex() = default;
+
+        explicit StopIndex(const std::deque<Stop>& stops);
+
+        // Не больше max_count ближайших к point остановок не дальше max_distance метров, по возрастанию
+        // расстояния, при равенстве — по названию
+        std::vector<NearbyStop> FindNearest(geo::Coordinates point,
+                                            size_t max_count = std::numeric_limits<size_t>::max(),
+                                            double max_distance = std::numeric_limits<double>::infinity()) const;
+
+    private:
+        // Границы сетки по координатам остановок и шаг ячейки в градусах
+        double min_lat_ = 0.;
+        double min_lng_ = 0.;
+        double max_lng_ = 0.;
+        double lat_step_ = 1.;
+        double lng_step_ = 1.;
+        size_t rows_ = 0;
+        size_t columns_ = 0;
+
+        // Остановки ячейки (row, column) занимают отрезок [cell_offsets_[c], cell_offsets_[c + 1]),
+        // где c = row * columns_ + column. Координаты лежат рядом с указателями, чтобы обход ячейки не ходил в deque
+        std::vector<uint32_t> cell_offsets_;
+        std::vector<const Stop*> cell_stops_;
+        std::vector<geo::Coordinates> cell_coordinates_;
+
+        size_t GetRow(double lat) const;
+
+        size_t GetColumn(double lng) const;
+
+        // Нижняя оценка расстояния от point до остановок вне прямоугольника ячеек
+        // [first_row, last_row] × [first_column, last_column]; бесконечность, если он покрывает всю сетку
+        double GetOutsideDistanceBound(geo::Coordinates point, size_t first_row, size_t last_row,
+                                       size_t first_column, size_t last_column) const;
+    };
+}
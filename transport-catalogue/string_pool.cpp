@@ -0,0 +1,84 @@
+#include "string_pool.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace strings {
+
+    StringPool::Id StringPool::Intern(std::string_view str) {
+        const size_t hash = std::hash<std::string_view>{}(str);
+        if (!slots_.empty()) {
+            if (const Id id = slots_[FindSlot(str, hash)]; id != EMPTY_SLOT) {
+                return id;
+            }
+        }
+
+        if ((strings_.size() + 1) * 2 > slots_.size()) {
+            Rehash(std::max<size_t>(16, slots_.size() * 2));
+        }
+
+        const auto id = static_cast<Id>(strings_.size());
+        strings_.push_back(Store(str));
+        hashes_.push_back(hash);
+        slots_[FindSlot(str, hash)] = id;
+
+        return id;
+    }
+
+    std::optional<StringPool::Id> StringPool::Find(std::string_view str) const {
+        if (slots_.empty()) {
+            return std::nullopt;
+        }
+
+        const Id id = slots_[FindSlot(str, std::hash<std::string_view>{}(str))];
+        return id == EMPTY_SLOT ? std::nullopt : std::optional<Id>(id);
+    }
+
+    size_t StringPool::FindSlot(std::string_view str, size_t hash) const {
+        const size_t mask = slots_.size() - 1;
+        // Строки сравниваются только при совпадении полных хешей
+        for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+            const Id id = slots_[slot];
+            if (id == EMPTY_SLOT || (hashes_[id] == hash && strings_[id] == str)) {
+                return slot;
+            }
+        }
+    }
+
+    std::string_view StringPool::Store(std::string_view str) {
+        // Пустой строке место в блоке не нужно, а блоков может ещё не быть
+        if (str.empty()) {
+            return {};
+        }
+        if (str.size() > BLOCK_SIZE) {
+            large_blocks_.push_back(std::make_unique<char[]>(str.size()));
+            std::memcpy(large_blocks_.back().get(), str.data(), str.size());
+            return {large_blocks_.back().get(), str.size()};
+        }
+
+        if (block_used_ + str.size() > BLOCK_SIZE) {
+            blocks_.push_back(std::make_unique<char[]>(BLOCK_SIZE));
+            block_used_ = 0;
+        }
+
+        char* const data = blocks_.back().get() + block_used_;
+        std::memcpy(data, str.data(), str.size());
+        block_used_ += str.size();
+
+        return {data, str.size()};
+    }
+
+    void StringPool::Rehash(size_t slot_count) {
+        slots_.assign(slot_count, EMPTY_SLOT);
+
+        const size_t mask = slot_count - 1;
+        for (Id id = 0; id < strings_.size(); ++id) {
+            size_t slot = hashes_[id] & mask;
+            while (slots_[slot] != EMPTY_SLOT) {
+                slot = (slot + 1) & mask;
+            }
+            slots_[slot] = id;
+        }
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// string_pool — пул интернированных строк: каждая строка хранится один раз в блоках общей памяти,
+// получает номер и заранее посчитанный хеш. Представления строк не меняются, пока жив пул
+
+namespace strings {
+
+    class StringPool {
+    public:
+        using Id = uint32_t;
+
+        StringPool() = default;
+
+        // Представления указывают в блоки пула, поэтому копировать пул нельзя, а перемещать — можно
+        StringPool(const StringPool&) = delete;
+        StringPool& operator=(const StringPool&) = delete;
+        StringPool(StringPool&&) = default;
+        StringPool& operator=(StringPool&&) = default;
+
+        // Номер строки; новая строка копируется в пул и получает следующий номер
+        Id Intern(std::string_view str);
+
+        std::optional<Id> Find(std::string_view str) const;
+
+        std::string_view Get(Id id) const {
+            return strings_[id];
+        }
+
+        size_t GetHash(Id id) const {
+            return hashes_[id];
+        }
+
+        size_t GetSize() const {
+            return strings_.size();
+        }
+
+    private:
+        static constexpr Id EMPTY_SLOT = std::numeric_limits<Id>::max();
+        static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+        // Строки лежат подряд в блоках; строка длиннее блока получает собственный блок в large_blocks_
+        std::vector<std::unique_ptr<char[]>> blocks_;
+        size_t block_used_ = BLOCK_SIZE;
+        std::vector<std::unique_ptr<char[]>> large_blocks_;
+
+        std::vector<std::string_view> strings_;
+        std::vector<size_t> hashes_;
+
+        // Таблица с открытой адресацией по номерам строк; размер — степень двойки, заполнение не больше половины
+        std::vector<Id> slots_;
+
+        size_t FindSlot(std::string_view str, size_t hash) const;
+
+        std::string_view Store(std::string_view str);
+
+        void Rehash(size_t slot_count);
+    };
+}
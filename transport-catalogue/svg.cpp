@@ -156,6 +156,10 @@ namespace svg {
         objects_.push_back(std::move(obj));
     }
 
+    void Document::Clear() {
+        objects_.clear();
+    }
+
     void Document::Render(std::ostream& out) const {
         out << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
         out << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
@@ -277,6 +277,9 @@ namespace svg {
         // Выводит в ostream svg-представление документа
         void Render(std::ostream& out) const;
 
+        // Удаляет из документа все объекты
+        void Clear();
+
         // Прочие методы и данные, необходимые для реализации класса Document
     };
 
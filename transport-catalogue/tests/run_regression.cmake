@@ -0,0 +1,57 @@
+# Регрессионная проверка transport_catalogue, запускается через cmake -P.
+# Строит базу из MAKE_BASE, при заданном UPDATE_BASE применяет к ней update_base, отвечает на запросы
+# PROCESS_REQUESTS и сравнивает ответ с EXPECTED. Файл базы создаётся в WORK_DIR.
+# ROUTER, GRAPH и WEIGHTS, если заданы, дописываются в routing_settings входа make_base
+#
+# Параметры: BINARY, WORK_DIR, MAKE_BASE, [UPDATE_BASE], [ROUTER, GRAPH, WEIGHTS], PROCESS_REQUESTS, EXPECTED
+
+foreach(parameter BINARY WORK_DIR MAKE_BASE PROCESS_REQUESTS EXPECTED)
+    if(NOT DEFINED ${parameter})
+        message(FATAL_ERROR "${parameter} is not set")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+# Запускает transport_catalogue в режиме mode на входе input; ответ остаётся в ${WORK_DIR}/${mode}.out
+function(run_mode mode input)
+    execute_process(COMMAND "${BINARY}" ${mode} --threads 2
+                    INPUT_FILE "${input}"
+                    OUTPUT_FILE "${WORK_DIR}/${mode}.out"
+                    ERROR_VARIABLE error
+                    RESULT_VARIABLE result
+                    WORKING_DIRECTORY "${WORK_DIR}")
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${mode} failed (${result}): ${error}")
+    endif()
+endfunction()
+
+set(make_base_input "${MAKE_BASE}")
+if(DEFINED ROUTER)
+    file(READ "${MAKE_BASE}" make_base)
+    set(marker "\"routing_settings\": {")
+    string(FIND "${make_base}" "${marker}" position)
+    if(position EQUAL -1)
+        message(FATAL_ERROR "${MAKE_BASE} has no routing_settings")
+    endif()
+    string(REPLACE "${marker}"
+                   "${marker}\"router\": \"${ROUTER}\", \"graph\": \"${GRAPH}\", \"weights\": \"${WEIGHTS}\", "
+                   make_base "${make_base}")
+    set(make_base_input "${WORK_DIR}/make_base.json")
+    file(WRITE "${make_base_input}" "${make_base}")
+endif()
+
+run_mode(make_base "${make_base_input}")
+if(DEFINED UPDATE_BASE)
+    run_mode(update_base "${UPDATE_BASE}")
+endif()
+run_mode(process_requests "${PROCESS_REQUESTS}")
+
+file(READ "${WORK_DIR}/process_requests.out" actual)
+file(READ "${EXPECTED}" expected)
+string(STRIP "${actual}" actual)
+string(STRIP "${expected}" expected)
+if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "Answer differs from ${EXPECTED}, see ${WORK_DIR}/process_requests.out")
+endif()
@@ -0,0 +1,75 @@
+#include "thread_pool.h"
+
+namespace concurrency {
+
+    size_t GetDefaultThreadCount() {
+        return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    ThreadPool::ThreadPool(size_t thread_count) {
+        const size_t workers_count = std::max<size_t>(thread_count, 1) - 1;
+        workers_.reserve(workers_count);
+        for (size_t i = 0; i < workers_count; ++i) {
+            workers_.emplace_back([this] {
+                WorkerLoop();
+            });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(mutex_);
+            stop_ = true;
+        }
+        job_ready_.notify_all();
+
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::RunOnAllThreads(const std::function<void()>& job) {
+        {
+            std::lock_guard lock(mutex_);
+            job_ = job;
+            ++generation_;
+            active_workers_ = workers_.size();
+        }
+        job_ready_.notify_all();
+
+        job();
+
+        std::unique_lock lock(mutex_);
+        job_done_.wait(lock, [this] {
+            return active_workers_ == 0;
+        });
+        job_ = nullptr;
+    }
+
+    void ThreadPool::WorkerLoop() {
+        size_t seen_generation = 0;
+
+        while (true) {
+            std::function<void()> job;
+            {
+                std::unique_lock lock(mutex_);
+                job_ready_.wait(lock, [this, seen_generation] {
+                    return stop_ || generation_ != seen_generation;
+                });
+                if (stop_) {
+                    return;
+                }
+                seen_generation = generation_;
+                job = job_;
+            }
+
+            job();
+
+            {
+                std::lock_guard lock(mutex_);
+                --active_workers_;
+            }
+            job_done_.notify_one();
+        }
+    }
+}
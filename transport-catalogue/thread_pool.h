@@ -0,0 +1,90 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// thread_pool — пул потоков для параллельной обработки независимых диапазонов индексов
+
+namespace concurrency {
+
+    // Количество потоков по умолчанию — число аппаратных потоков, но не меньше одного
+    size_t GetDefaultThreadCount();
+
+    class ThreadPool {
+    public:
+        // Вызывающий поток тоже участвует в работе, поэтому рабочих потоков создаётся thread_count - 1
+        explicit ThreadPool(size_t thread_count);
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool();
+
+        size_t GetThreadCount() const {
+            return workers_.size() + 1;
+        }
+
+        // Делит [begin, end) на блоки по grain элементов и вызывает func(block_begin, block_end) на потоках пула.
+        // Возвращает управление, когда обработаны все блоки. Если func бросит исключение на любом потоке,
+        // оставшиеся блоки не раздаются, а первое исключение пробрасывается вызывающему после завершения всех потоков
+        template <typename Func>
+        void ParallelFor(size_t begin, size_t end, size_t grain, Func func);
+
+    private:
+        std::vector<std::thread> workers_;
+
+        std::mutex mutex_;
+        std::condition_variable job_ready_;
+        std::condition_variable job_done_;
+        std::function<void()> job_;
+        size_t generation_ = 0;
+        size_t active_workers_ = 0;
+        bool stop_ = false;
+
+        void RunOnAllThreads(const std::function<void()>& job);
+
+        void WorkerLoop();
+    };
+
+    template <typename Func>
+    void ThreadPool::ParallelFor(size_t begin, size_t end, size_t grain, Func func) {
+        if (begin >= end) {
+            return;
+        }
+        grain = std::max<size_t>(grain, 1);
+        if (workers_.empty() || end - begin <= grain) {
+            func(begin, end);
+            return;
+        }
+
+        // Исключение не должно покинуть задачу: рабочие потоки ссылаются на func и next, пока не закончат,
+        // а исключение в рабочем потоке завершило бы программу
+        std::atomic<size_t> next{begin};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+        RunOnAllThreads([&next, end, grain, &func, &error_mutex, &error] {
+            try {
+                for (size_t block_begin = next.fetch_add(grain); block_begin < end; block_begin = next.fetch_add(grain)) {
+                    func(block_begin, std::min(block_begin + grain, end));
+                }
+            } catch (...) {
+                next.store(end);
+                std::lock_guard lock(error_mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
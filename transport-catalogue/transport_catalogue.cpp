@@ -1,104 +1,306 @@
 #include "transport_catalogue.h"
 
 #include <numeric>
+#include <tuple>
 #include <stdexcept>
 #include <algorithm>
 
 namespace transport_catalogue {
 
     void TransportCatalogue::AddStop(std::tuple<std::string , double, double>& stop) {
+        AddStop(std::move(stop));
+    }
+
+    void TransportCatalogue::AddStop(std::tuple<std::string , double, double>&& stop) {
+        CheckNotFrozen();
         auto& [name_stop, x, y] = stop;
 
-        stops_.push_front({move(name_stop), {x, y}});
+        const auto id = static_cast<StopId>(stops_.size());
+        const auto name_id = names_.Intern(name_stop);
+        if (name_id >= name_stops_.size()) {
+            name_stops_.resize(name_id + 1, NO_ID);
+        }
+        name_stops_[name_id] = id;
 
-        stopname_to_stop_[stops_.front().stop_name] = &stops_.front();
+        stops_.push_back({id, names_.Get(name_id), {x, y}});
+        stop_vectors_.push_back(geo::ToUnitVector(stops_.back().coordinates));
+        stop_buses_.emplace_back();
+    }
 
-        stop_and_stopping_buses_[stops_.front().stop_name];
+    const Stop* TransportCatalogue::FindStop(std::string_view stop) const {
+        if (const auto id = FindStopId(stop)) {
+            return &stops_[*id];
+        }
+
+        return nullptr;
     }
 
-    void TransportCatalogue::AddStop(std::tuple<std::string , double, double>&& stop) {
-        auto& [name_stop, x, y] = stop;
+    std::optional<StopId> TransportCatalogue::FindStopId(std::string_view stop) const {
+        if (const auto name_id = names_.Find(stop); name_id && *name_id < name_stops_.size()
+                                                    && name_stops_[*name_id] != NO_ID) {
+            return name_stops_[*name_id];
+        }
 
-        stops_.push_front({move(name_stop), {x, y}});
+        return std::nullopt;
+    }
+
+    const Bus* TransportCatalogue::FindBus(std::string_view bus) const {
+        if (const auto id = FindBusId(bus)) {
+            return &buses_[*id];
+        }
+
+        return nullptr;
+    }
 
-        stopname_to_stop_[stops_.front().stop_name] = &stops_.front();
+    std::optional<BusId> TransportCatalogue::FindBusId(std::string_view bus) const {
+        if (const auto name_id = names_.Find(bus); name_id && *name_id < name_buses_.size()
+                                                   && name_buses_[*name_id] != NO_ID) {
+            return name_buses_[*name_id];
+        }
 
-        stop_and_stopping_buses_[stops_.front().stop_name];
+        return std::nullopt;
     }
 
     void TransportCatalogue::AddBus(std::string& bus, std::vector<std::string>& stops, bool is_roundtrip) {
-        std::vector<Stop*> new_stops;
-        std::unordered_set<std::string_view> unique_stops;
+        CheckNotFrozen();
+        if (distances_changed_) {
+            FreezeRoadDistances();
+        }
 
+        std::vector<Stop*> new_stops;
+        new_stops.reserve(stops.size());
         for (auto& stop : stops) {
-            new_stops.push_back(stopname_to_stop_[stop]);
-            unique_stops.insert(stopname_to_stop_[stop]->stop_name);
+            new_stops.push_back(&stops_[FindStopId(stop).value()]);
         }
 
-        buses_.push_front(std::move(Bus{bus, new_stops, unique_stops, is_roundtrip}));
-        busname_to_bus_[buses_.front().bus_name] = &buses_.front();
+        const auto id = static_cast<BusId>(buses_.size());
+        const auto name_id = names_.Intern(bus);
+        if (name_id >= name_buses_.size()) {
+            name_buses_.resize(name_id + 1, NO_ID);
+        }
+        name_buses_[name_id] = id;
 
-        for (auto stop : buses_.front().stops) {
-            stop_and_stopping_buses_[stop->stop_name].insert(&buses_.front());
+        buses_.push_back(Bus{id, names_.Get(name_id), std::move(new_stops), 0, is_roundtrip});
+        Bus& new_bus = buses_.back();
+
+        // Новый автобус добавляется в конец списков, поэтому повтор остановки виден по последнему элементу,
+        // а первые вхождения остановок заодно дают их число без повторов
+        for (const Stop* stop : new_bus.stops) {
+            auto& stop_buses = stop_buses_[stop->id];
+            if (stop_buses.empty() || stop_buses.back() != &new_bus) {
+                stop_buses.push_back(&new_bus);
+                ++new_bus.unique_stop_count;
+            }
         }
 
-        for (size_t i = 0, j = 1; j < busname_to_bus_.at(bus)->stops.size(); ++i, ++j) {
-            Stop* const lhs = busname_to_bus_.at(bus)->stops[i];
-            Stop* const rhs = busname_to_bus_.at(bus)->stops[j];
+        // Расстояние по прямой симметрично, поэтому обратный путь некольцевого автобуса равен пути туда
+        if (new_bus.stops.size() > 1) {
+            std::vector<geo::UnitVector> points;
+            points.reserve(new_bus.stops.size());
+            for (const Stop* stop : new_bus.stops) {
+                points.push_back(stop_vectors_[stop->id]);
+            }
+            std::vector<double> distances(points.size() - 1);
+            geo::ComputeDistances(points.data(), points.data() + 1, distances.size(), distances.data());
 
-            busname_to_bus_.at(bus)->geographic_distance += ComputeDistance(lhs->coordinates, rhs->coordinates);
+            new_bus.geographic_distance = std::accumulate(distances.begin(), distances.end(), 0.);
+            if (!is_roundtrip) {
+                new_bus.geographic_distance *= 2;
+            }
+        }
 
-            if (stops_distance_.count({lhs, rhs})) {
-                busname_to_bus_.at(bus)->route_length += stops_distance_.at({lhs, rhs});
-            } else if (stops_distance_.count({rhs, lhs})) {
-                busname_to_bus_.at(bus)->route_length += stops_distance_.at({rhs, lhs});
+        const RouteView route = new_bus.GetRoute();
+        for (size_t i = 0, j = 1; j < route.size(); ++i, ++j) {
+            const Stop* const lhs = route[i];
+            const Stop* const rhs = route[j];
+
+            if (const auto distance = GetRoadDistance(lhs->id, rhs->id)) {
+                new_bus.route_length += static_cast<int>(*distance);
             }
         }
     }
 
     void TransportCatalogue::SetDistanceBetweenStops(std::tuple<std::string, int, std::string>& stop_distance_to_stop) {
+        CheckNotFrozen();
         auto& [stop_first, distance, stop_second] = stop_distance_to_stop;
-        stops_distance_[{stopname_to_stop_.at(stop_first), stopname_to_stop_.at(stop_second)}] = distance;
+        road_distances_.push_back({FindStopId(stop_first).value(), FindStopId(stop_second).value(), distance});
+        distances_changed_ = true;
+    }
+
+    void TransportCatalogue::FreezeRoadDistances() {
+        const auto by_stops = [](const RoadDistance& lhs, const RoadDistance& rhs) {
+            return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+        };
+        const auto same_stops = [](const RoadDistance& lhs, const RoadDistance& rhs) {
+            return lhs.from == rhs.from && lhs.to == rhs.to;
+        };
+
+        // Из повторов остаётся последнее заданное расстояние
+        std::reverse(road_distances_.begin(), road_distances_.end());
+        std::stable_sort(road_distances_.begin(), road_distances_.end(), by_stops);
+        road_distances_.erase(std::unique(road_distances_.begin(), road_distances_.end(), same_stops),
+                              road_distances_.end());
+        road_distances_.shrink_to_fit();
+
+        // Обратные направления идут после заданных, поэтому при совпадении остаётся заданное
+        std::vector<RoadDistance> distances = road_distances_;
+        distances.reserve(road_distances_.size() * 2);
+        for (const auto& [from, to, distance] : road_distances_) {
+            distances.push_back({to, from, distance});
+        }
+        std::stable_sort(distances.begin(), distances.end(), by_stops);
+        distances.erase(std::unique(distances.begin(), distances.end(), same_stops), distances.end());
+
+        distance_offsets_.assign(stops_.size() + 1, 0);
+        for (const auto& road_distance : distances) {
+            ++distance_offsets_[road_distance.from + 1];
+        }
+        for (size_t stop = 0; stop < stops_.size(); ++stop) {
+            distance_offsets_[stop + 1] += distance_offsets_[stop];
+        }
+
+        distance_neighbours_.clear();
+        distance_neighbours_.reserve(distances.size());
+        for (const auto& [from, to, distance] : distances) {
+            distance_neighbours_.emplace_back(to, distance);
+        }
+
+        distances_changed_ = false;
+    }
+
+    std::optional<double> TransportCatalogue::GetRoadDistance(StopId from, StopId to) const {
+        if (distances_changed_) {
+            // Поиск до заморозки: последнее заданное расстояние в эту сторону, иначе в обратную
+            const auto find_last = [this](StopId lhs, StopId rhs) {
+                return std::find_if(road_distances_.rbegin(), road_distances_.rend(),
+                                    [lhs, rhs](const RoadDistance& road_distance) {
+                                        return road_distance.from == lhs && road_distance.to == rhs;
+                                    });
+            };
+            if (const auto it = find_last(from, to); it != road_distances_.rend()) {
+                return it->distance;
+            }
+            if (const auto it = find_last(to, from); it != road_distances_.rend()) {
+                return it->distance;
+            }
+            return std::nullopt;
+        }
+
+        if (from + 1 >= distance_offsets_.size()) {
+            return std::nullopt;
+        }
+
+        const auto begin = distance_neighbours_.begin() + distance_offsets_[from];
+        const auto end = distance_neighbours_.begin() + distance_offsets_[from + 1];
+        const auto it = std::lower_bound(begin, end, to, [](const std::pair<StopId, int>& neighbour, StopId stop) {
+            return neighbour.first < stop;
+        });
+        if (it != end && it->first == to) {
+            return it->second;
+        }
+
+        return std::nullopt;
+    }
+
+    void TransportCatalogue::CheckNotFrozen() const {
+        if (is_frozen_) {
+            throw std::logic_error("Transport catalogue is frozen");
+        }
+    }
+
+    void TransportCatalogue::Freeze() {
+        if (is_frozen_) {
+            return;
+        }
+        if (distances_changed_) {
+            FreezeRoadDistances();
+        }
+
+        bus_infos_.clear();
+        bus_infos_.reserve(buses_.size());
+        sorted_buses_.clear();
+        sorted_buses_.reserve(buses_.size());
+        for (const Bus& bus : buses_) {
+            bus_infos_.push_back(MakeBusInfo(bus));
+            sorted_buses_.push_back(&bus);
+        }
+        std::sort(sorted_buses_.begin(), sorted_buses_.end(), [] (const Bus* lhs, const Bus* rhs) {
+            return lhs->bus_name < rhs->bus_name;
+        });
+
+        // Автобусы перебираются по возрастанию названия, поэтому списки остановок получаются отсортированными
+        stop_bus_names_.assign(stops_.size(), {});
+        for (StopId stop = 0; stop < stops_.size(); ++stop) {
+            stop_bus_names_[stop].reserve(stop_buses_[stop].size());
+        }
+        for (const Bus* bus : sorted_buses_) {
+            for (const Stop* stop : bus->stops) {
+                auto& names = stop_bus_names_[stop->id];
+                if (names.empty() || names.back() != bus->bus_name) {
+                    names.push_back(bus->bus_name);
+                }
+            }
+        }
+
+        stop_index_ = StopIndex(stops_);
+
+        is_frozen_ = true;
+    }
+
+    BusInfo TransportCatalogue::MakeBusInfo(const Bus& bus) {
+        return BusInfo{bus.bus_name,
+                       bus.route_length / bus.geographic_distance,
+                       double(bus.route_length),
+                       bus.GetRoute().size(),
+                       bus.unique_stop_count};
     }
 
     std::optional<BusInfo> TransportCatalogue::GetBusInfo(std::string_view bus) const {
-        if (busname_to_bus_.count(bus)) {
-            return BusInfo{busname_to_bus_.at(bus)->bus_name,
-                    busname_to_bus_.at(bus)->route_length / busname_to_bus_.at(bus)->geographic_distance,
-                           double(busname_to_bus_.at(bus)->route_length),
-                    busname_to_bus_.at(bus)->stops.size(),
-                    busname_to_bus_.at(bus)->unique_stops.size()};
+        if (const auto id = FindBusId(bus)) {
+            return is_frozen_ ? bus_infos_[*id] : MakeBusInfo(buses_[*id]);
         }
         return std::nullopt;
     }
 
-    const std::unordered_set<Bus*>* TransportCatalogue::GetStopInfo(std::string_view stop) const {
-        if (stop_and_stopping_buses_.count(stop)) {
-            return &stop_and_stopping_buses_.at(stop);
+    const std::vector<std::string_view>* TransportCatalogue::GetStopBusNames(std::string_view stop) const {
+        if (!is_frozen_) {
+            throw std::logic_error("Transport catalogue should be frozen to list stop buses");
+        }
+        if (const auto id = FindStopId(stop)) {
+            return &stop_bus_names_[*id];
         }
 
         return nullptr;
     }
 
-    std::vector<const Bus*> TransportCatalogue::GetBuses() const {
-        std::vector<const Bus*> buses(buses_.size());
+    std::vector<NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates point, size_t max_count,
+                                                                 double max_distance) const {
+        if (!is_frozen_) {
+            throw std::logic_error("Transport catalogue should be frozen to search stops by coordinates");
+        }
+        return stop_index_.FindNearest(point, max_count, max_distance);
+    }
 
-        std::transform(buses_.begin(), buses_.end(), buses.begin(), [](const Bus& bus){
-            return &bus;
-        });
+    const std::vector<Bus*>* TransportCatalogue::GetStopInfo(std::string_view stop) const {
+        if (const auto id = FindStopId(stop)) {
+            return &stop_buses_[*id];
+        }
 
-        std::sort(buses.begin(), buses.end(), [] (const Bus* lhs, const Bus* rhs) {
-            return lhs->bus_name < rhs->bus_name;
-        });
+        return nullptr;
+    }
 
-        return buses;
+    const std::vector<const Bus*>& TransportCatalogue::GetBuses() const {
+        if (!is_frozen_) {
+            throw std::logic_error("Transport catalogue should be frozen to list buses");
+        }
+        return sorted_buses_;
     }
 
     std::vector<const Stop*> TransportCatalogue::GetStopsIncludedInRoutes() const {
         std::vector<const Stop*> stops;
 
         for (const Stop& stop : stops_) {
-            if (!stop_and_stopping_buses_.at(stop.stop_name).empty()) {
+            if (!stop_buses_[stop.id].empty()) {
                 stops.push_back(&stop);
             }
         }
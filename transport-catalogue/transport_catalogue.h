@@ -2,10 +2,14 @@
 
 #include "domain.h"
 #include "geo.h"
+#include "stop_index.h"
+#include "string_pool.h"
 
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <deque>
+#include <limits>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
@@ -17,56 +21,129 @@ namespace transport_catalogue {
 
     class TransportCatalogue {
     private:
-        struct StopsDistanceHasher {
-            size_t operator() (const std::pair<Stop*, Stop*> stops) const {
-                size_t h_x = d_hasher_(stops.first);
-                size_t h_y = d_hasher_(stops.second);
-
-                return h_x + h_y * 1000000007;
-            }
-
-        private:
-            std::hash<const void*> d_hasher_;
-        };
+        static constexpr uint32_t NO_ID = std::numeric_limits<uint32_t>::max();
 
+        // Сущности лежат в deque, чтобы указатели на них не менялись при добавлении; номер сущности — её индекс.
+        // Названия переводятся в номера только на входе в каталог, дальше данные берутся из векторов по номерам
         std::deque<Stop> stops_;
         std::deque<Bus> buses_;
-        std::unordered_map<std::string_view, Stop*> stopname_to_stop_;
-        std::unordered_map<std::string_view, Bus*> busname_to_bus_;
-        std::unordered_map<std::string_view, std::unordered_set<Bus*>> stop_and_stopping_buses_;
-        std::unordered_map<std::pair<Stop*, Stop*>, int, StopsDistanceHasher> stops_distance_;
+        // Точки остановок на единичной сфере по номерам: расстояния по прямой в AddBus считаются без тригонометрии
+        std::vector<geo::UnitVector> stop_vectors_;
+        // Названия остановок и автобусов хранятся один раз в общем пуле; по номеру названия в пуле
+        // находится остановка и автобус с этим названием или NO_ID
+        strings::StringPool names_;
+        std::vector<StopId> name_stops_;
+        std::vector<BusId> name_buses_;
+        // Автобусы, проходящие через остановку, в порядке добавления, без повторов
+        std::vector<std::vector<Bus*>> stop_buses_;
+        struct RoadDistance {
+            StopId from;
+            StopId to;
+            int distance;
+        };
+
+        // Заданные расстояния; новые добавляются в конец, и при повторе действует последнее.
+        // Заморозка оставляет в массиве по одному расстоянию на направление
+        std::vector<RoadDistance> road_distances_;
+
+        // Замороженные расстояния: соседи остановки s с расстояниями до них, по возрастанию номера соседа,
+        // занимают отрезок [distance_offsets_[s], distance_offsets_[s + 1]) массива distance_neighbours_.
+        // Расстояние в обратную сторону, если оно не задано явно, записано здесь же
+        std::vector<uint32_t> distance_offsets_;
+        std::vector<std::pair<StopId, int>> distance_neighbours_;
+        // Заданы расстояния, которых ещё нет в замороженных массивах
+        bool distances_changed_ = false;
+
+        // Перестраивает замороженные массивы по road_distances_
+        void FreezeRoadDistances();
+
+        // Снимок для запросов, который строит Freeze: сводки автобусов по номерам, отсортированные названия
+        // автобусов каждой остановки, автобусы по возрастанию названия и пространственный индекс остановок
+        bool is_frozen_ = false;
+        std::vector<BusInfo> bus_infos_;
+        std::vector<std::vector<std::string_view>> stop_bus_names_;
+        std::vector<const Bus*> sorted_buses_;
+        StopIndex stop_index_;
+
+        static BusInfo MakeBusInfo(const Bus& bus);
+
+        void CheckNotFrozen() const;
 
     public:
+        // Изменения возможны только до Freeze; после него методы изменения бросают std::logic_error
         void AddStop(std::tuple<std::string , double, double>& stop);
         void AddStop(std::tuple<std::string , double, double>&& stop);
 
-        Stop FindStop(std::string_view);
+        const Stop* FindStop(std::string_view stop) const;
+
+        std::optional<StopId> FindStopId(std::string_view stop) const;
 
+        const Stop& GetStop(StopId id) const {
+            return stops_[id];
+        }
+
+        // Для некольцевого автобуса stops — путь только в одну сторону, обратный путь каталог не хранит
         void AddBus(std::string& bus, std::vector<std::string>& stops, bool is_roundtrip);
 
         void SetDistanceBetweenStops(std::tuple<std::string, int, std::string>& stop_distance_to_stop);
 
-        Bus FindBus(std::string_view);
+        const Bus* FindBus(std::string_view bus) const;
+
+        std::optional<BusId> FindBusId(std::string_view bus) const;
+
+        const Bus& GetBus(BusId id) const {
+            return buses_[id];
+        }
+
+        size_t GetBusesCount() const {
+            return buses_.size();
+        }
+
+        // Завершает загрузку: замораживает дорожные расстояния и строит снимок для запросов,
+        // после чего GetBusInfo, GetStopBusNames, GetBuses и FindNearestStops читают готовые массивы
+        void Freeze();
+
+        bool IsFrozen() const {
+            return is_frozen_;
+        }
 
         std::optional<BusInfo> GetBusInfo(std::string_view bus) const;
 
-        const std::unordered_set<Bus*>* GetStopInfo(std::string_view stop) const;
+        // Названия автобусов остановки по возрастанию; nullptr, если остановки нет. Требует Freeze
+        const std::vector<std::string_view>* GetStopBusNames(std::string_view stop) const;
 
-        std::vector<const Bus*> GetBuses() const;
+        // Не больше max_count ближайших к point остановок каталога не дальше max_distance метров,
+        // по возрастанию расстояния. Требует Freeze
+        std::vector<NearbyStop> FindNearestStops(geo::Coordinates point,
+                                                 size_t max_count = std::numeric_limits<size_t>::max(),
+                                                 double max_distance = std::numeric_limits<double>::infinity()) const;
 
+        // Автобусы, проходящие через остановку; nullptr, если остановки нет в каталоге
+        const std::vector<Bus*>* GetStopInfo(std::string_view stop) const;
+
+        const std::vector<Bus*>& GetStopBuses(StopId id) const {
+            return stop_buses_[id];
+        }
+
+        // Автобусы по возрастанию названия. Требует Freeze
+        const std::vector<const Bus*>& GetBuses() const;
+
+        // Остановки, через которые проходит хотя бы один автобус, в порядке номеров
         std::vector<const Stop*> GetStopsIncludedInRoutes() const;
 
         size_t GetStopsCount() const {
-            return stop_and_stopping_buses_.size();
+            return stops_.size();
         };
 
         std::optional<double> GetDistanceBetweenTwoStops(std::pair<std::string_view, std::string_view> stops) const {
             auto& [lhs, rhs] = stops;
-            if (stops_distance_.count({stopname_to_stop_.at(lhs), stopname_to_stop_.at(rhs)})) {
-                return stops_distance_.at({stopname_to_stop_.at(lhs), stopname_to_stop_.at(rhs)});
-            }
-
-            return std::nullopt;
+            return GetRoadDistance(FindStopId(lhs).value(), FindStopId(rhs).value());
         }
+
+        // Дорожное расстояние от from до to по номерам, без поиска по названиям;
+        // если расстояние в эту сторону не задано, берётся расстояние в обратную.
+        // Расстояния замораживаются при добавлении автобуса, поэтому после загрузки поиск — просмотр нескольких
+        // соседних элементов массива. Расстояния, заданные после последнего AddBus, ищутся перебором
+        std::optional<double> GetRoadDistance(StopId from, StopId to) const;
     };
 }
@@ -1,137 +1,725 @@
 #include "transport_router.h"
 
-RouteBuilder::RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time)
-        : db_(db), bus_velocity_(bus_velocity), bus_wait_time_(bus_wait_time) {
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <tuple>
+#include <type_traits>
+
+RouteBuilder::RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                           RouterType router_type, GraphModel graph_model, WeightType weight_type, size_t thread_count,
+                           size_t route_cache_size)
+        : db_(db), bus_velocity_(bus_velocity), bus_wait_time_(bus_wait_time), graph_model_(graph_model)
+        , weight_type_(weight_type), router_type_(router_type), route_cache_(route_cache_size) {
+    if (router_type_ == RouterType::kRaptor) {
+        raptor_ = std::make_unique<transit::RaptorRouter>(db_, bus_velocity_, bus_wait_time_);
+        return;
+    }
+
+    BuildGraph();
+    CreateRouter(router_type, thread_count);
+}
+
+RouteBuilder::RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                           RouterType router_type, GraphModel graph_model, WeightType weight_type,
+                           serialization_data::RouterData&& previous_data,
+                           const std::unordered_map<std::string_view, uint32_t>& name_ids,
+                           size_t thread_count, size_t route_cache_size)
+        : db_(db), bus_velocity_(bus_velocity), bus_wait_time_(bus_wait_time), graph_model_(graph_model)
+        , weight_type_(weight_type), router_type_(router_type), route_cache_(route_cache_size) {
+    if (router_type_ == RouterType::kRaptor) {
+        raptor_ = std::make_unique<transit::RaptorRouter>(db_, bus_velocity_, bus_wait_time_);
+        return;
+    }
+
+    BuildGraph();
+    if (!UpdateRouter(router_type, std::move(previous_data), name_ids, thread_count)) {
+        CreateRouter(router_type, thread_count);
+    }
+}
+
+void RouteBuilder::BuildGraph() {
     const auto& stops = db_.GetStopsIncludedInRoutes();
+    const auto& buses = db_.GetBuses();
 
-    id_bus_stop_entrance_.reserve(db_.GetStopsCount());
+    stop_entrances_.assign(db_.GetStopsCount(), NO_VERTEX);
+    stops_count_ = stops.size();
+    edge_names_.reserve(stops.size() + buses.size());
 
-    graph_ = std::unique_ptr<graph::DirectedWeightedGraph<double>>(new graph::DirectedWeightedGraph<double>{db_.GetStopsIncludedInRoutes().size() * 2});
+    Edges edges;
 
     {
-        size_t counter = 0;
+        uint32_t counter = 0;
 
         for (auto stop : stops) {
-            id_bus_stop_entrance_[stop->stop_name] = counter;
-            graph_->AddEdge({counter,
-                            counter + 1,
-                            bus_wait_time_,
-                            stop->stop_name,
-                            0});
+            stop_entrances_[stop->id] = counter;
+            edges.push_back({counter,
+                             counter + 1,
+                             bus_wait_time_,
+                             static_cast<uint32_t>(edge_names_.size()),
+                             0});
+            edge_names_.push_back(stop->stop_name);
             counter += 2;
         }
     }
 
-    const auto& buses = db_.GetBuses();
-
     for (auto bus : buses) {
-        if (!bus->is_roundtrip) {
-            BuildGraphEdgesIsNotRoundtrip(bus->stops, bus->bus_name, 0, (bus->stops.size() / 2) + 1);
-            BuildGraphEdgesIsNotRoundtrip(bus->stops, bus->bus_name, bus->stops.size() / 2, bus->stops.size());
+        const auto bus_name_id = static_cast<uint32_t>(edge_names_.size());
+        edge_names_.push_back(bus->bus_name);
+
+        const RouteStops route_stops = PrepareRouteStops(bus->GetRoute());
+        const size_t route_size = route_stops.stops.size();
+
+        if (graph_model_ == GraphModel::kLinear) {
+            // Пересадка в точке разворота требует нового ожидания, как и в модели pairwise
+            if (!bus->is_roundtrip) {
+                BuildRideChain(route_stops, bus_name_id, 0, (route_size / 2) + 1, edges);
+                BuildRideChain(route_stops, bus_name_id, route_size / 2, route_size, edges);
+            } else {
+                BuildRideChain(route_stops, bus_name_id, 0, route_size, edges);
+            }
+        } else if (!bus->is_roundtrip) {
+            BuildGraphEdgesIsNotRoundtrip(route_stops, bus_name_id, 0, (route_size / 2) + 1, edges);
+            BuildGraphEdgesIsNotRoundtrip(route_stops, bus_name_id, route_size / 2, route_size, edges);
         } else {
-            BuildGraphEdgesIsRoundtrip(bus->stops, bus->bus_name);
+            BuildGraphEdgesIsRoundtrip(route_stops, bus_name_id, edges);
         }
     }
 
-    router_ = std::unique_ptr<graph::Router<double>>(new graph::Router<double>{*graph_.get()});
+    graph_ = std::make_unique<Graph>(GetRideVerticesBegin() + ride_distances_.size(), std::move(edges));
 }
 
-double  RouteBuilder::CalculateEdgeTravelTime(double weight) const {
-    const static double minutes_in_one_hour = 60.;
-    const static double meters_in_one_kilometer = 1000.;
+void RouteBuilder::CreateRouter(RouterType router_type, size_t thread_count) {
+    if (weight_type_ == WeightType::kFixedPoint) {
+        BuildFixedGraph();
+        fixed_router_ = MakeRouter<FixedWeight>(*fixed_graph_, router_type, thread_count);
+    } else {
+        router_ = MakeRouter<double>(*graph_, router_type, thread_count);
+    }
+}
 
-    return (weight * minutes_in_one_hour) / (meters_in_one_kilometer * bus_velocity_);
+void RouteBuilder::BuildFixedGraph() {
+    std::vector<graph::CompactEdge<FixedWeight>> edges;
+    edges.reserve(graph_->GetEdgeCount());
+    for (const auto& [from, to, weight, name_id, span_count] : graph_->GetEdges()) {
+        edges.push_back({from, to, ToFixedWeight(weight), name_id, span_count});
+    }
+
+    fixed_graph_ = std::make_unique<FixedGraph>(graph_->GetOffsets(), std::move(edges));
+    graph_.reset();
 }
 
-void RouteBuilder::BuildEdge(const std::vector<transport_catalogue::Stop*>& route_stops, std::string_view bus_name, size_t from, size_t to) {
-    double weight = 0.;
+RouteBuilder::FixedWeight RouteBuilder::ToFixedWeight(double minutes) {
+    const double units = std::round(minutes * FIXED_WEIGHT_UNITS_IN_MINUTE);
+    // Половина диапазона остаётся под сумму весов пути и бесконечный вес таблицы all_pairs
+    if (units > std::numeric_limits<FixedWeight>::max() / 4) {
+        throw std::out_of_range("Edge travel time is too large for fixed-point weights");
+    }
+    return static_cast<FixedWeight>(units);
+}
 
-    size_t span_count = 0;
+double RouteBuilder::ToMinutes(double weight) {
+    return weight;
+}
 
-    for (int lhs = from, rhs = from + 1; route_stops[lhs] != route_stops[to]; ++lhs, ++rhs) {
-        if (rhs == route_stops.size()) {
-            lhs = 0; rhs = 1;
+double RouteBuilder::ToMinutes(FixedWeight weight) {
+    return weight / FIXED_WEIGHT_UNITS_IN_MINUTE;
+}
+
+template <typename Weight, typename WeightGraph>
+std::unique_ptr<graph::RouterBase<Weight>> RouteBuilder::MakeRouter(const WeightGraph& graph, RouterType router_type,
+                                                                    size_t thread_count) const {
+    switch (router_type) {
+        case RouterType::kDijkstra:
+            return std::make_unique<graph::DijkstraRouter<Weight, WeightGraph>>(graph);
+        case RouterType::kAStar:
+            return std::make_unique<graph::DijkstraRouter<Weight, WeightGraph>>(graph, MakeGeoHeuristic<Weight>(graph));
+        default:
+            return std::make_unique<graph::Router<Weight, WeightGraph>>(graph, thread_count);
+    }
+}
+
+template <typename Weight, typename WeightGraph>
+std::unique_ptr<graph::RouterBase<Weight>> RouteBuilder::RestoreRouter(const WeightGraph& graph, RouterType router_type,
+                                                                       serialization_data::RouterData& router_data) const {
+    if (router_type != RouterType::kAllPairs) {
+        return MakeRouter<Weight>(graph, router_type, 1);
+    }
+
+    using Router = graph::Router<Weight, WeightGraph>;
+    typename Router::RoutesInternalData routes_internal_data;
+    if constexpr (std::is_same_v<Weight, double>) {
+        routes_internal_data.weights = std::move(router_data.route_weights);
+    } else {
+        // Целые веса таблицы хранятся в double без потерь
+        routes_internal_data.weights.assign(router_data.route_weights.begin(), router_data.route_weights.end());
+        router_data.route_weights.clear();
+    }
+    routes_internal_data.prev_edges = std::move(router_data.route_prev_edges);
+
+    return std::make_unique<Router>(graph, std::move(routes_internal_data));
+}
+
+RouteBuilder::RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                           RouterType router_type, GraphModel graph_model, WeightType weight_type,
+                           serialization_data::RouterData&& router_data,
+                           const std::unordered_map<uint32_t, std::string>& id_names,
+                           size_t route_cache_size)
+        : db_(db), bus_velocity_(bus_velocity), bus_wait_time_(bus_wait_time), graph_model_(graph_model)
+        , weight_type_(weight_type), router_type_(router_type), ride_distances_(std::move(router_data.ride_distances))
+        , route_cache_(route_cache_size) {
+    if (router_type_ == RouterType::kRaptor) {
+        raptor_ = std::make_unique<transit::RaptorRouter>(db_, bus_velocity_, bus_wait_time_);
+        return;
+    }
+
+    const size_t stops_count = router_data.stop_vertices.size();
+
+    edge_names_.reserve(router_data.names.size());
+    for (size_t i = 0; i < router_data.names.size(); ++i) {
+        const std::string& name = id_names.at(router_data.names[i]);
+        if (i < stops_count) {
+            edge_names_.push_back(db_.FindStop(name)->stop_name);
+        } else {
+            edge_names_.push_back(db_.FindBus(name)->bus_name);
         }
-        auto distance = db_.GetDistanceBetweenTwoStops({route_stops[lhs]->stop_name,
-                                                        route_stops[rhs]->stop_name});
-        if (!distance) {
-            distance = db_.GetDistanceBetweenTwoStops({route_stops[rhs]->stop_name,
-                                                       route_stops[lhs]->stop_name});
+    }
+
+    stop_entrances_.assign(db_.GetStopsCount(), NO_VERTEX);
+    stops_count_ = stops_count;
+    for (size_t i = 0; i < stops_count; ++i) {
+        stop_entrances_[*db_.FindStopId(edge_names_[i])] = router_data.stop_vertices[i];
+    }
+
+    Edges edges;
+    edges.reserve(router_data.edges.size());
+    for (const auto& [from, to, weight, name, span_count] : router_data.edges) {
+        edges.push_back({from, to, weight, name, span_count});
+    }
+
+    graph_ = std::make_unique<Graph>(std::move(router_data.offsets), std::move(edges));
+
+    if (weight_type_ == WeightType::kFixedPoint) {
+        BuildFixedGraph();
+        fixed_router_ = RestoreRouter<FixedWeight>(*fixed_graph_, router_type, router_data);
+    } else {
+        router_ = RestoreRouter<double>(*graph_, router_type, router_data);
+    }
+}
+
+bool RouteBuilder::UpdateRouter(RouterType router_type, serialization_data::RouterData&& previous_data,
+                                const std::unordered_map<std::string_view, uint32_t>& name_ids, size_t thread_count) {
+    // Вершины модели linear зависят от длины и порядка всех рейсов, поэтому переносить таблицу можно только в pairwise
+    if (router_type != RouterType::kAllPairs || graph_model_ != GraphModel::kPairwise
+        || previous_data.route_weights.empty()
+        || previous_data.offsets.size() != graph_->GetVertexCount() + 1
+        || previous_data.stop_vertices.size() != stops_count_) {
+        return false;
+    }
+
+    // Каждая остановка должна сохранить свои вершины
+    std::unordered_map<uint32_t, size_t> stop_vertices;
+    for (transport_catalogue::StopId id = 0; id < stop_entrances_.size(); ++id) {
+        if (stop_entrances_[id] != NO_VERTEX) {
+            stop_vertices[name_ids.at(db_.GetStop(id).stop_name)] = stop_entrances_[id];
+        }
+    }
+    for (size_t i = 0; i < previous_data.stop_vertices.size(); ++i) {
+        const auto it = stop_vertices.find(previous_data.names[i]);
+        if (it == stop_vertices.end() || it->second != previous_data.stop_vertices[i]) {
+            return false;
+        }
+    }
+
+    // Ребро сохраняется, если совпали концы, название, число перегонов и вес; изменённый вес — это удаление и добавление.
+    // Веса fixed_point сравниваются после округления: в базе они хранятся уже округлёнными
+    const auto key_weight = [this](double weight) {
+        return weight_type_ == WeightType::kFixedPoint ? ToMinutes(ToFixedWeight(weight)) : weight;
+    };
+    using EdgeKey = std::tuple<uint32_t, uint32_t, uint32_t, uint32_t, double>;
+    std::map<EdgeKey, std::vector<uint32_t>> new_edges_by_key;
+    for (uint32_t edge_id = 0; edge_id < graph_->GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph_->GetEdge(edge_id);
+        new_edges_by_key[{edge.from, edge.to, name_ids.at(edge_names_[edge.name_id]), edge.span_count,
+                          key_weight(edge.weight)}].push_back(edge_id);
+    }
+
+    std::vector<uint32_t> new_edge_ids(previous_data.edges.size(), graph::Router<double, Graph>::NO_EDGE);
+    for (size_t edge_id = 0; edge_id < previous_data.edges.size(); ++edge_id) {
+        const auto& [from, to, weight, name, span_count] = previous_data.edges[edge_id];
+        const auto it = new_edges_by_key.find({from, to, previous_data.names[name], span_count, key_weight(weight)});
+        if (it != new_edges_by_key.end() && !it->second.empty()) {
+            new_edge_ids[edge_id] = it->second.back();
+            it->second.pop_back();
+        }
+    }
+
+    std::vector<graph::EdgeId> added_edges;
+    for (const auto& [key, edge_ids] : new_edges_by_key) {
+        added_edges.insert(added_edges.end(), edge_ids.begin(), edge_ids.end());
+    }
+    std::sort(added_edges.begin(), added_edges.end());
+
+    if (weight_type_ == WeightType::kFixedPoint) {
+        BuildFixedGraph();
+        using Router = graph::Router<FixedWeight, FixedGraph>;
+        Router::RoutesInternalData previous_table{{previous_data.route_weights.begin(), previous_data.route_weights.end()},
+                                                  std::move(previous_data.route_prev_edges)};
+        fixed_router_ = std::make_unique<Router>(*fixed_graph_, std::move(previous_table), new_edge_ids, added_edges,
+                                                 thread_count);
+    } else {
+        using Router = graph::Router<double, Graph>;
+        router_ = std::make_unique<Router>(*graph_, Router::RoutesInternalData{std::move(previous_data.route_weights),
+                                                                               std::move(previous_data.route_prev_edges)},
+                                           new_edge_ids, added_edges, thread_count);
+    }
+    return true;
+}
+
+serialization_data::RouterData RouteBuilder::GetRouterData(const std::unordered_map<std::string_view, uint32_t>& name_ids) const {
+    serialization_data::RouterData router_data;
+
+    // Движок raptor строится по каталогу при загрузке базы, сохранять нечего
+    if (router_type_ == RouterType::kRaptor) {
+        return router_data;
+    }
+
+    router_data.names.reserve(edge_names_.size());
+    for (const auto name : edge_names_) {
+        router_data.names.push_back(name_ids.at(name));
+    }
+
+    router_data.stop_vertices.reserve(stops_count_);
+    for (size_t i = 0; i < stops_count_; ++i) {
+        router_data.stop_vertices.push_back(stop_entrances_[*db_.FindStopId(edge_names_[i])]);
+    }
+
+    // Веса рёбер сохраняются в минутах; для fixed_point они при загрузке переводятся обратно в те же целые
+    const auto save_graph = [&router_data](const auto& graph) {
+        router_data.edges.reserve(graph.GetEdgeCount());
+        for (const auto& edge : graph.GetEdges()) {
+            router_data.edges.push_back({edge.from, edge.to, ToMinutes(edge.weight), edge.name_id, edge.span_count});
+        }
+        router_data.offsets = graph.GetOffsets();
+    };
+    if (fixed_graph_) {
+        save_graph(*fixed_graph_);
+    } else {
+        save_graph(*graph_);
+    }
+    router_data.ride_distances = ride_distances_;
+
+    if (const auto* router = dynamic_cast<const graph::Router<double, Graph>*>(router_.get())) {
+        router_data.route_weights = router->GetRoutesInternalData().weights;
+        router_data.route_prev_edges = router->GetRoutesInternalData().prev_edges;
+    } else if (const auto* router = dynamic_cast<const graph::Router<FixedWeight, FixedGraph>*>(fixed_router_.get())) {
+        const auto& weights = router->GetRoutesInternalData().weights;
+        router_data.route_weights.assign(weights.begin(), weights.end());
+        router_data.route_prev_edges = router->GetRoutesInternalData().prev_edges;
+    }
+
+    return router_data;
+}
+
+template <typename Weight, typename WeightGraph>
+typename graph::DijkstraRouter<Weight, WeightGraph>::Heuristic RouteBuilder::MakeGeoHeuristic(const WeightGraph& graph) const {
+    // Вершины входа и посадки остановки имеют её координаты
+    std::vector<geo::Coordinates> vertex_coordinates(graph.GetVertexCount());
+    for (transport_catalogue::StopId id = 0; id < stop_entrances_.size(); ++id) {
+        if (const uint32_t vertex = stop_entrances_[id]; vertex != NO_VERTEX) {
+            vertex_coordinates[vertex] = vertex_coordinates[vertex + 1] = db_.GetStop(id).coordinates;
+        }
+    }
+    // Вершина поездки модели linear находится там же, где остановка, с которой на неё садятся
+    const size_t ride_vertices_begin = GetRideVerticesBegin();
+    for (const auto& edge : graph.GetEdges()) {
+        if (edge.from < ride_vertices_begin && edge.to >= ride_vertices_begin) {
+            vertex_coordinates[edge.to] = vertex_coordinates[edge.from];
+        }
+    }
+
+    double scale = std::numeric_limits<double>::infinity();
+    for (const auto& edge : graph.GetEdges()) {
+        const double distance = geo::ComputeDistance(vertex_coordinates[edge.from], vertex_coordinates[edge.to]);
+        if (distance > 0.) {
+            scale = std::min(scale, edge.weight / distance);
+        }
+    }
+    // Запас на погрешность вычислений с плавающей точкой, чтобы оценка не превысила истинный вес
+    scale = std::isfinite(scale) ? scale * (1. - 1e-9) : 0.;
+
+    return [scale, vertex_coordinates = std::move(vertex_coordinates)](graph::VertexId vertex, graph::VertexId to) {
+        return static_cast<Weight>(scale * geo::ComputeDistance(vertex_coordinates[vertex], vertex_coordinates[to]));
+    };
+}
+
+size_t RouteBuilder::GetRideVerticesBegin() const {
+    return stops_count_ * 2;
+}
+
+std::optional<size_t> RouteBuilder::FindStopEntrance(std::string_view stop_name) const {
+    const auto id = db_.FindStopId(stop_name);
+    if (!id || stop_entrances_[*id] == NO_VERTEX) {
+        return std::nullopt;
+    }
+    return stop_entrances_[*id];
+}
+
+RouteBuilder::RouteStops RouteBuilder::PrepareRouteStops(transport_catalogue::RouteView stops) const {
+    RouteStops route_stops{stops,
+                           std::vector<uint32_t>(stops.size()),
+                           std::vector<double>(stops.size()),
+                           std::vector<size_t>(stops.size())};
+
+    std::unordered_map<transport_catalogue::StopId, size_t> last_occurrences;
+    last_occurrences.reserve(stops.size());
+
+    for (size_t i = 0; i < stops.size(); ++i) {
+        route_stops.entrances[i] = stop_entrances_[stops[i]->id];
+        if (i > 0) {
+            route_stops.distances[i] = route_stops.distances[i - 1]
+                                       + db_.GetRoadDistance(stops[i - 1]->id, stops[i]->id).value();
         }
 
-        weight += distance.value();
-        ++span_count;
+        const auto [it, inserted] = last_occurrences.emplace(stops[i]->id, i);
+        route_stops.prev_occurrences[i] = inserted ? i : it->second;
+        it->second = i;
+    }
+
+    return route_stops;
+}
+
+double  RouteBuilder::CalculateEdgeTravelTime(double weight) const {
+    const static double minutes_in_one_hour = 60.;
+    const static double meters_in_one_kilometer = 1000.;
+
+    return (weight * minutes_in_one_hour) / (meters_in_one_kilometer * bus_velocity_);
+}
+
+void RouteBuilder::BuildEdge(const RouteStops& route_stops, uint32_t bus_name_id, size_t from, size_t to,
+                             Edges& edges) {
+    // Поездка заканчивается на первом после from вхождении остановки stops[to]
+    size_t arrival = to;
+    while (route_stops.prev_occurrences[arrival] != arrival && route_stops.prev_occurrences[arrival] >= from) {
+        arrival = route_stops.prev_occurrences[arrival];
     }
 
-    weight = CalculateEdgeTravelTime(weight);
+    // Расстояния — целые числа, поэтому разность префиксных сумм совпадает с суммой перегонов точно
+    const double weight = CalculateEdgeTravelTime(route_stops.distances[arrival] - route_stops.distances[from]);
+    const size_t span_count = arrival - from;
 
-    graph_->AddEdge({id_bus_stop_entrance_[route_stops[from]->stop_name] + 1,
-                    id_bus_stop_entrance_[route_stops[to]->stop_name],
-                    weight,
-                    bus_name,
-                    span_count});
+    edges.push_back({route_stops.entrances[from] + 1,
+                     route_stops.entrances[to],
+                     weight,
+                     bus_name_id,
+                     static_cast<uint32_t>(span_count)});
 }
 
-void RouteBuilder::BuildGraphEdgesIsNotRoundtrip(const std::vector<transport_catalogue::Stop*>& route_stops, std::string_view bus_name, size_t begin, size_t end) {
+void RouteBuilder::BuildGraphEdgesIsNotRoundtrip(const RouteStops& route_stops, uint32_t bus_name_id, size_t begin, size_t end,
+                                                 Edges& edges) {
     for (size_t i = begin; i < end; ++i) {
         for (size_t j = i; j < end; ++j) {
             if (i == j) {
                 continue;
             }
 
-            BuildEdge(route_stops, bus_name, i, j);
+            BuildEdge(route_stops, bus_name_id, i, j, edges);
         }
     }
 }
 
-void RouteBuilder::BuildGraphEdgesIsRoundtrip(const std::vector<transport_catalogue::Stop*>& route_stops, std::string_view bus_name) {
+void RouteBuilder::BuildGraphEdgesIsRoundtrip(const RouteStops& route_stops, uint32_t bus_name_id,
+                                              Edges& edges) {
 
-    for (size_t i = 0; i < route_stops.size() - 1; ++i) {
-        for (size_t j = i + 1; j < route_stops.size(); ++j) {
-            if (i == j || (i == 0 && j == route_stops.size() - 1)) {
+    for (size_t i = 0; i < route_stops.stops.size() - 1; ++i) {
+        for (size_t j = i + 1; j < route_stops.stops.size(); ++j) {
+            if (i == j || (i == 0 && j == route_stops.stops.size() - 1)) {
                 continue;
             }
 
-            BuildEdge(route_stops, bus_name, i, j);
+            BuildEdge(route_stops, bus_name_id, i, j, edges);
         }
     }
 
 }
 
-std::optional<Route> RouteBuilder::GetRout(std::string_view from, std::string_view to) const {
-    if (!id_bus_stop_entrance_.count(from) || !id_bus_stop_entrance_.count(to)) {
-        return std::nullopt;
+void RouteBuilder::BuildRideChain(const RouteStops& route_stops, uint32_t bus_name_id, size_t begin, size_t end,
+                                  Edges& edges) {
+    const auto first_vertex = static_cast<uint32_t>(GetRideVerticesBegin() + ride_distances_.size());
+
+    for (size_t i = begin; i < end; ++i) {
+        const auto vertex = static_cast<uint32_t>(first_vertex + (i - begin));
+        const uint32_t entrance = route_stops.entrances[i];
+
+        if (i > begin) {
+            const double hop_distance = route_stops.distances[i] - route_stops.distances[i - 1];
+            edges.push_back({vertex - 1, vertex, CalculateEdgeTravelTime(hop_distance), bus_name_id, 1});
+        }
+        ride_distances_.push_back(route_stops.distances[i]);
+
+        edges.push_back({entrance + 1, vertex, 0., bus_name_id, 0});
+        edges.push_back({vertex, entrance, 0., bus_name_id, 0});
+    }
+}
+
+RouteBuilder::RoutePtr RouteBuilder::GetRout(std::string_view from, std::string_view to) const {
+    // Концы маршрута — вершины графа или, для движка raptor, номера остановок
+    size_t vertex_from = 0;
+    size_t vertex_to = 0;
+    if (router_type_ == RouterType::kRaptor) {
+        const auto stop_from = raptor_->FindStop(from);
+        const auto stop_to = raptor_->FindStop(to);
+        if (!stop_from || !stop_to) {
+            return nullptr;
+        }
+        vertex_from = *stop_from;
+        vertex_to = *stop_to;
+    } else {
+        const auto entrance_from = FindStopEntrance(from);
+        const auto entrance_to = FindStopEntrance(to);
+        if (!entrance_from || !entrance_to) {
+            return nullptr;
+        }
+        vertex_from = *entrance_from;
+        vertex_to = *entrance_to + 1;
     }
     if (from == to) {
-        return Route{0, {}};
+        return std::make_shared<const Route>(Route{0, {}});
     }
 
-    std::optional<graph::Router<double>::RouteInfo> route_info = router_->BuildRoute(id_bus_stop_entrance_.at(from),
-                                                                                     id_bus_stop_entrance_.at(to) + 1);
+    const uint64_t key = (static_cast<uint64_t>(vertex_from) << 32) | vertex_to;
 
-    if (!route_info) {
-        return std::nullopt;
+    if (auto route = route_cache_.Get(key)) {
+        return *route;
     }
 
-    Route route;
+    // Поиск выполняется без блокировки: одновременные промахи по одной паре лишь повторят работу
+    RoutePtr route;
+    if (router_type_ == RouterType::kRaptor) {
+        const auto stop_to = static_cast<uint32_t>(vertex_to);
+        if (const auto journey = raptor_->GetJourney(raptor_->Search(static_cast<uint32_t>(vertex_from), stop_to), stop_to)) {
+            route = std::make_shared<const Route>(raptor_->MakeRoute(*journey));
+        }
+    } else {
+        route = fixed_router_ ? FindRoute(*fixed_router_, vertex_from, vertex_to)
+                              : FindRoute(*router_, vertex_from, vertex_to);
+    }
+
+    route_cache_.Put(key, route);
 
-    route.total_time = route_info->weight - bus_wait_time_;
+    return route;
+}
+
+template <typename Weight>
+RouteBuilder::RoutePtr RouteBuilder::FindRoute(const graph::RouterBase<Weight>& router, size_t vertex_from,
+                                               size_t vertex_to) const {
+    if (const auto route_info = router.BuildRoute(vertex_from, vertex_to)) {
+        return std::make_shared<const Route>(MakeRoute(route_info->weight, route_info->edges));
+    }
+    return nullptr;
+}
 
-    route.items.reserve(route_info.value().edges.size());
+cache::CacheStats RouteBuilder::GetRouteCacheStats() const {
+    return route_cache_.GetStats();
+}
 
-    for (auto& id_edge : route_info.value().edges) {
-        const auto& edge = graph_->GetEdge(id_edge);
+std::vector<std::vector<std::optional<Route>>> RouteBuilder::GetRouteMatrix(const std::vector<std::string>& from,
+                                                                            const std::vector<std::string>& to) const {
+    std::vector<std::vector<std::optional<Route>>> routes(from.size(), std::vector<std::optional<Route>>(to.size()));
+
+    if (router_type_ == RouterType::kRaptor) {
+        FillRaptorRouteMatrix(from, to, routes);
+    } else if (fixed_router_) {
+        FillRouteMatrix(*fixed_router_, from, to, routes);
+    } else {
+        FillRouteMatrix(*router_, from, to, routes);
+    }
+
+    return routes;
+}
+
+void RouteBuilder::FillRaptorRouteMatrix(const std::vector<std::string>& from,
+                                         const std::vector<std::string>& to,
+                                         std::vector<std::vector<std::optional<Route>>>& routes) const {
+    // Поиск без цели даёт точные времена до всех остановок, поэтому он один на каждую остановку отправления
+    std::unordered_map<uint32_t, transit::RaptorRouter::Profile> profiles;
+
+    for (size_t row = 0; row < from.size(); ++row) {
+        const auto stop_from = raptor_->FindStop(from[row]);
+        if (!stop_from) {
+            continue;
+        }
+        auto it = profiles.find(*stop_from);
+        if (it == profiles.end()) {
+            it = profiles.emplace(*stop_from, raptor_->Search(*stop_from)).first;
+        }
+
+        for (size_t column = 0; column < to.size(); ++column) {
+            const auto stop_to = raptor_->FindStop(to[column]);
+            if (!stop_to) {
+                continue;
+            }
+            if (*stop_from == *stop_to) {
+                routes[row][column] = Route{0, {}};
+            } else if (const auto journey = raptor_->GetJourney(it->second, *stop_to)) {
+                routes[row][column] = raptor_->MakeRoute(*journey);
+            }
+        }
+    }
+}
+
+std::vector<std::pair<std::string_view, double>> RouteBuilder::GetReachableStops(std::string_view from,
+                                                                                 double max_time) const {
+    std::vector<std::pair<std::string_view, double>> stops;
+    // Отрицательное время и NaN не ограничивают ни одной остановки
+    if (!(max_time >= 0.)) {
+        return stops;
+    }
+
+    if (router_type_ == RouterType::kRaptor) {
+        if (const auto stop_from = raptor_->FindStop(from)) {
+            stops = raptor_->FindStopsWithinTime(*stop_from, max_time);
+        }
+    } else if (const auto entrance = FindStopEntrance(from)) {
+        // Время больше наибольшего целого веса ничего не отсекает, поэтому граница сводится к нему
+        const double max_fixed_weight = std::min(std::floor(max_time * FIXED_WEIGHT_UNITS_IN_MINUTE),
+                                                 static_cast<double>(std::numeric_limits<FixedWeight>::max()));
+        stops = fixed_router_
+                ? FindReachableStops(*fixed_graph_, *entrance, static_cast<FixedWeight>(max_fixed_weight))
+                : FindReachableStops(*graph_, *entrance, max_time);
+    }
+
+    std::sort(stops.begin(), stops.end(), [](const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.second, lhs.first) < std::tie(rhs.second, rhs.first);
+    });
+
+    return stops;
+}
+
+template <typename Weight, typename WeightGraph>
+std::vector<std::pair<std::string_view, double>> RouteBuilder::FindReachableStops(const WeightGraph& graph,
+                                                                                  size_t vertex_from,
+                                                                                  Weight max_weight) const {
+    std::vector<std::pair<std::string_view, double>> stops;
+
+    // Остановка i занимает вершины входа 2i и посадки 2i + 1, вершины поездки модели linear идут после них
+    const size_t ride_vertices_begin = GetRideVerticesBegin();
+    for (const auto& [vertex, weight] : graph::FindVerticesWithinWeight(graph, vertex_from, max_weight)) {
+        if (vertex < ride_vertices_begin && vertex % 2 == 0) {
+            stops.emplace_back(edge_names_[vertex / 2], ToMinutes(weight));
+        }
+    }
+
+    return stops;
+}
+
+template <typename Weight>
+void RouteBuilder::FillRouteMatrix(const graph::RouterBase<Weight>& router,
+                                   const std::vector<std::string>& from,
+                                   const std::vector<std::string>& to,
+                                   std::vector<std::vector<std::optional<Route>>>& routes) const {
+    // Строки с одинаковой остановкой отправления заполняются по одному дереву путей
+    std::unordered_map<size_t, std::vector<size_t>> rows_by_origin;
+    for (size_t row = 0; row < from.size(); ++row) {
+        if (const auto entrance = FindStopEntrance(from[row])) {
+            rows_by_origin[*entrance].push_back(row);
+        }
+    }
+
+    std::vector<std::optional<size_t>> entrances_to;
+    entrances_to.reserve(to.size());
+    for (const auto& stop_name : to) {
+        entrances_to.push_back(FindStopEntrance(stop_name));
+    }
+
+    for (const auto& [origin, rows] : rows_by_origin) {
+        const auto tree = router.BuildRoutesTree(origin);
+
+        for (size_t column = 0; column < to.size(); ++column) {
+            if (!entrances_to[column]) {
+                continue;
+            }
+
+            std::optional<Route> route;
+            if (origin == *entrances_to[column]) {
+                route = Route{0, {}};
+            } else if (const auto route_info = router.BuildRoute(tree, *entrances_to[column] + 1)) {
+                route = MakeRoute(route_info->weight, route_info->edges);
+            }
+
+            for (const size_t row : rows) {
+                routes[row][column] = route;
+            }
+        }
+    }
+}
+
+template <typename Weight>
+Route RouteBuilder::MakeRoute(Weight weight, const std::vector<graph::EdgeId>& edges) const {
+    constexpr bool is_fixed_weight = std::is_same_v<Weight, FixedWeight>;
+    const auto& route_graph = [this]() -> const graph::FrozenGraph<Weight>& {
+        if constexpr (is_fixed_weight) {
+            return *fixed_graph_;
+        } else {
+            return *graph_;
+        }
+    }();
+
+    Route route;
+
+    route.total_time = ToMinutes(weight) - bus_wait_time_;
+
+    route.items.reserve(edges.size());
+
+    const size_t ride_vertices_begin = GetRideVerticesBegin();
+    size_t boarding_vertex = 0;
+    Weight ride_weight = 0;
+
+    for (auto& id_edge : edges) {
+        const auto& edge = route_graph.GetEdge(id_edge);
+
+        if (edge.from >= ride_vertices_begin) {
+            // Модель linear: перегон или высадка продолжают поездку, начатую посадкой
+            Item& item = route.items.back();
+            item.span_count += edge.span_count;
+            ride_weight += edge.weight;
+            if (edge.to < ride_vertices_begin) {
+                if constexpr (is_fixed_weight) {
+                    // Целые веса перегонов складываются без погрешности
+                    item.time = ToMinutes(ride_weight);
+                } else {
+                    item.time = CalculateEdgeTravelTime(ride_distances_[edge.from - ride_vertices_begin]
+                                                        - ride_distances_[boarding_vertex - ride_vertices_begin]);
+                }
+            }
+            continue;
+        }
 
         Item item;
-        item.name = edge.name;
+        item.name = edge_names_[edge.name_id];
         item.span_count = edge.span_count;
-        item.time = edge.weight;
+        item.time = ToMinutes(edge.weight);
 
-        item.item_type = (id_bus_stop_entrance_.count(edge.name)) ? Item::Type::kWait : Item::Type::kBus;
+        item.item_type = (edge.name_id < stops_count_) ? Item::Type::kWait : Item::Type::kBus;
+
+        if (edge.to >= ride_vertices_begin) {
+            boarding_vertex = edge.to;
+            ride_weight = edge.weight;
+        }
 
         route.items.push_back(std::move(item));
     }
     route.items.resize(route.items.size() - 1);
 
+    if (graph_model_ == GraphModel::kLinear || weight_type_ == WeightType::kFixedPoint) {
+        // Сумма времён поездок совпадает с ответом модели pairwise точнее, чем сумма весов перегонов,
+        // а для fixed_point итог согласован с временами элементов без ожидания на остановке назначения
+        route.total_time = 0.;
+        for (const auto& item : route.items) {
+            route.total_time += item.time;
+        }
+    }
+
     return route;
 }
@@ -3,41 +3,216 @@
 #include "transport_catalogue.h"
 #include "graph.h"
 #include "router.h"
+#include "dijkstra_router.h"
 #include "domain.h"
+#include "geo.h"
+#include "lru_cache.h"
+#include "raptor.h"
 
+#include <cstdint>
+#include <limits>
 #include <string_view>
 #include <vector>
 #include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
 
 class RouteBuilder {
+public:
+    // Найденный маршрут; nullptr, если маршрута нет. Один объект разделяют все запросы с той же парой остановок
+    using RoutePtr = std::shared_ptr<const Route>;
+
+    static constexpr size_t DEFAULT_ROUTE_CACHE_SIZE = serialization_data::RouteSettings{}.route_cache_size;
+
 private:
+    using Graph = graph::FrozenGraph<double>;
+    using Edges = std::vector<graph::CompactEdge<double>>;
+
+    // Вес fixed_point — целое число сотых долей секунды
+    using FixedWeight = uint32_t;
+    using FixedGraph = graph::FrozenGraph<FixedWeight>;
+    static constexpr double FIXED_WEIGHT_UNITS_IN_MINUTE = 6000.;
+
     const transport_catalogue::TransportCatalogue& db_;
 
-    std::unique_ptr<graph::DirectedWeightedGraph<double>> graph_;
-    std::unique_ptr<graph::Router<double>> router_;
+    std::unique_ptr<Graph> graph_;
+    std::unique_ptr<graph::RouterBase<double>> router_;
+
+    // Для весов fixed_point граф строится с весами double и переводится в fixed_graph_ с целыми весами и теми же
+    // номерами рёбер; после перевода graph_ освобождается, router_ не создаётся. Времена ответа берутся из fixed_graph_
+    std::unique_ptr<FixedGraph> fixed_graph_;
+    std::unique_ptr<graph::RouterBase<FixedWeight>> fixed_router_;
 
     const double bus_velocity_;
     const double bus_wait_time_;
+    const GraphModel graph_model_;
+    const WeightType weight_type_;
+
+    // Движок raptor работает без графа: graph_ и маршрутизаторы не создаются. Для остальных движков raptor_ пуст
+    const RouterType router_type_;
+    std::unique_ptr<transit::RaptorRouter> raptor_;
+
+    static constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+    // Вершина входа на остановку по её номеру в каталоге; NO_VERTEX, если через остановку не ходят автобусы.
+    // Остановки с вершинами занимают первые 2 * stops_count_ вершин графа
+    std::vector<uint32_t> stop_entrances_;
+    size_t stops_count_ = 0;
+
+    // Названия, на которые ссылаются рёбра графа: сначала остановки (рёбра ожидания), затем автобусы
+    std::vector<std::string_view> edge_names_;
 
-    std::unordered_map<std::string_view, size_t> id_bus_stop_entrance_;
+    // Модель linear: вершины поездки нумеруются после вершин остановок, для каждой хранится
+    // расстояние от начала рейса — по нему время поездки считается так же, как в модели pairwise
+    std::vector<double> ride_distances_;
 
-    void BuildEdge(const std::vector<transport_catalogue::Stop*>& route_stops,
-                   std::string_view bus_name,
+    // Кеш ответов GetRout по паре (вершина отправления, вершина назначения), общий для всех запросов.
+    // Разбит на сегменты, чтобы параллельные запросы Route не ждали друг друга на одном мьютексе
+    mutable cache::ShardedLruCache<uint64_t, RoutePtr> route_cache_;
+
+    size_t GetRideVerticesBegin() const;
+
+    // Вершина входа на остановку по названию — единственный поиск по названию на запрос
+    std::optional<size_t> FindStopEntrance(std::string_view stop_name) const;
+
+    // Остановки рейса с предрассчитанными данными, по которым вес любого ребра находится за O(1)
+    struct RouteStops {
+        transport_catalogue::RouteView stops;
+        // Вершина входа на stops[i]
+        std::vector<uint32_t> entrances;
+        // Дорожное расстояние от начала рейса до stops[i]
+        std::vector<double> distances;
+        // Индекс предыдущего вхождения stops[i] в рейс или i, если остановка встречается впервые
+        std::vector<size_t> prev_occurrences;
+    };
+
+    RouteStops PrepareRouteStops(transport_catalogue::RouteView stops) const;
+
+    void BuildEdge(const RouteStops& route_stops,
+                   uint32_t bus_name_id,
                    size_t begin,
-                   size_t end);
+                   size_t end,
+                   Edges& edges);
 
-    void BuildGraphEdgesIsNotRoundtrip(const std::vector<transport_catalogue::Stop*>& route_stops,
-                                       std::string_view bus_name,
+    void BuildGraphEdgesIsNotRoundtrip(const RouteStops& route_stops,
+                                       uint32_t bus_name_id,
                                        size_t begin,
-                                       size_t end);
+                                       size_t end,
+                                       Edges& edges);
 
-    void BuildGraphEdgesIsRoundtrip(const std::vector<transport_catalogue::Stop*>& route_stops,
-                                    std::string_view bus_name);
+    void BuildGraphEdgesIsRoundtrip(const RouteStops& route_stops,
+                                    uint32_t bus_name_id,
+                                    Edges& edges);
+
+    // Цепочка вершин поездки для остановок [begin, end) рейса: перегоны между соседними вершинами,
+    // рёбра посадки с входа на остановку и высадки обратно на вход. Ожидание несёт ребро остановки
+    void BuildRideChain(const RouteStops& route_stops,
+                        uint32_t bus_name_id,
+                        size_t begin,
+                        size_t end,
+                        Edges& edges);
 
     double CalculateEdgeTravelTime(double weight) const;
 
+    // Строит граф маршрутов по каталогу
+    void BuildGraph();
+
+    void CreateRouter(RouterType router_type, size_t thread_count);
+
+    // Переводит graph_ в fixed_graph_ и освобождает graph_
+    void BuildFixedGraph();
+
+    static FixedWeight ToFixedWeight(double minutes);
+
+    static double ToMinutes(double weight);
+    static double ToMinutes(FixedWeight weight);
+
+    template <typename Weight, typename WeightGraph>
+    std::unique_ptr<graph::RouterBase<Weight>> MakeRouter(const WeightGraph& graph, RouterType router_type,
+                                                          size_t thread_count) const;
+
+    // Движок по сохранённым данным: таблица all_pairs берётся из router_data, остальные движки таблиц не хранят
+    template <typename Weight, typename WeightGraph>
+    std::unique_ptr<graph::RouterBase<Weight>> RestoreRouter(const WeightGraph& graph, RouterType router_type,
+                                                             serialization_data::RouterData& router_data) const;
+
+    // Переносит таблицу all_pairs прежней базы на новый граф, пересчитывая только затронутое изменениями.
+    // Возвращает false, если перенос невозможен: другой движок или модель графа, изменился набор остановок на маршрутах
+    bool UpdateRouter(RouterType router_type, serialization_data::RouterData&& previous_data,
+                      const std::unordered_map<std::string_view, uint32_t>& name_ids, size_t thread_count);
+
+    // Ответ на запрос по найденному пути от входа на остановку отправления до посадки на остановке назначения;
+    // weight — вес пути; времена элементов берутся из весов рёбер графа того же типа и переводятся в минуты
+    template <typename Weight>
+    Route MakeRoute(Weight weight, const std::vector<graph::EdgeId>& edges) const;
+
+    void FillRaptorRouteMatrix(const std::vector<std::string>& from,
+                               const std::vector<std::string>& to,
+                               std::vector<std::vector<std::optional<Route>>>& routes) const;
+
+    template <typename Weight>
+    RoutePtr FindRoute(const graph::RouterBase<Weight>& router, size_t vertex_from, size_t vertex_to) const;
+
+    template <typename Weight, typename WeightGraph>
+    std::vector<std::pair<std::string_view, double>> FindReachableStops(const WeightGraph& graph, size_t vertex_from,
+                                                                        Weight max_weight) const;
+
+    template <typename Weight>
+    void FillRouteMatrix(const graph::RouterBase<Weight>& router,
+                         const std::vector<std::string>& from,
+                         const std::vector<std::string>& to,
+                         std::vector<std::vector<std::optional<Route>>>& routes) const;
+
+    // Эвристика A*: расстояние по прямой до цели, умноженное на наименьшее по всем рёбрам отношение
+    // веса ребра к расстоянию по прямой между его концами. Такая оценка согласована при любых дорожных расстояниях,
+    // а для целых весов остаётся согласованной и после округления вниз
+    template <typename Weight, typename WeightGraph>
+    typename graph::DijkstraRouter<Weight, WeightGraph>::Heuristic MakeGeoHeuristic(const WeightGraph& graph) const;
+
 public:
-    RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time);
+    // thread_count — число потоков для предварительного расчёта таблицы движка all_pairs;
+    // route_cache_size — число ответов на запросы Route, которые хранит кеш маршрутов
+    RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                 RouterType router_type = RouterType::kAllPairs, GraphModel graph_model = GraphModel::kPairwise,
+                 WeightType weight_type = WeightType::kMinutes, size_t thread_count = 1,
+                 size_t route_cache_size = DEFAULT_ROUTE_CACHE_SIZE);
+
+    // Восстанавливает граф и маршрутизатор из данных, сохранённых на этапе make_base, без повторного расчёта
+    RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                 RouterType router_type, GraphModel graph_model, WeightType weight_type,
+                 serialization_data::RouterData&& router_data,
+                 const std::unordered_map<uint32_t, std::string>& id_names,
+                 size_t route_cache_size = DEFAULT_ROUTE_CACHE_SIZE);
+
+    // Строит граф для изменённого каталога и по возможности переносит в него таблицу маршрутизатора прежней базы
+    // previous_data, а не рассчитывает её заново. name_ids — идентификаторы названий, общие для обеих баз
+    RouteBuilder(const transport_catalogue::TransportCatalogue& db, double bus_velocity , double bus_wait_time,
+                 RouterType router_type, GraphModel graph_model, WeightType weight_type,
+                 serialization_data::RouterData&& previous_data,
+                 const std::unordered_map<std::string_view, uint32_t>& name_ids,
+                 size_t thread_count, size_t route_cache_size = DEFAULT_ROUTE_CACHE_SIZE);
+
+    serialization_data::RouterData GetRouterData(const std::unordered_map<std::string_view, uint32_t>& name_ids) const;
+
+    // Безопасен для одновременного вызова из нескольких потоков
+    RoutePtr GetRout(std::string_view from, std::string_view to) const;
+
+    // Попадания и промахи кеша GetRout с момента построения
+    cache::CacheStats GetRouteCacheStats() const;
+
+    // Маршруты между всеми парами остановок from[i], to[j]: один поиск на каждую различную остановку отправления.
+    // Для неизвестных остановок и недостижимых пар ячейка пуста
+    std::vector<std::vector<std::optional<Route>>> GetRouteMatrix(const std::vector<std::string>& from,
+                                                                  const std::vector<std::string>& to) const;
+
+    // Индекс raptor движка raptor; nullptr для остальных движков
+    const transit::RaptorRouter* GetRaptor() const {
+        return raptor_.get();
+    }
 
-    std::optional<Route> GetRout(std::string_view from, std::string_view to) const;
+    // Остановки, до которых можно доехать из from не дольше чем за max_time минут, и время в пути до них,
+    // по возрастанию времени. Ожидание на остановке прибытия не учитывается. Пусто, если остановка неизвестна,
+    // а также при отрицательном max_time или NaN
+    std::vector<std::pair<std::string_view, double>> GetReachableStops(std::string_view from, double max_time) const;
 };